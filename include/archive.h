@@ -0,0 +1,88 @@
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <filesystem>
+
+#include "rules.h"
+#include "throttle.h"
+
+// Entree de l'archive tar, dans l'ordre deterministe du parcours
+struct ArchiveEntry {
+    std::filesystem::path path; // Chemin local
+    std::string name;           // Nom dans l'archive (format tar: sans '/' initial)
+    char type = '0';            // '0' fichier, '5' dossier, '2' lien symbolique, '1' lien physique
+    uintmax_t size = 0;
+    uint32_t mode = 0644;
+    int64_t mtime = 0;
+    uint32_t uid = 0;
+    uint32_t gid = 0;
+    std::string uname;          // Proprietaires par nom (restauration sur un autre hote)
+    std::string gname;
+    std::string linkTarget;     // Cible du lien, ou nom de la premiere occurrence d'un lien physique
+};
+
+struct ArchiveStats {
+    uintmax_t entries = 0;
+    uintmax_t bytes = 0;         // Octets tar emis
+    std::vector<std::string> changedFiles; // Fichiers raccourcis/illisibles, completes par des zeros
+};
+
+// Parcours trie (reproductible) de sourceDir, elague par les regles d'exclusion.
+// unreadable recoit les dossiers impossibles a lister (permission refusee...)
+std::vector<ArchiveEntry> scanArchiveEntries(const std::string& sourceDir, RuleSet* rules = nullptr,
+                                             std::vector<std::string>* unreadable = nullptr);
+
+// Producteur tar parallele: plusieurs lecteurs remplissent des buffers recycles,
+// un sequenceur emet les blocs dans l'ordre vers sink (fenetre de reordonnancement bornee).
+class ArchiveProducer {
+public:
+    // Copie directe d'une plage de fichier vers la sortie (moved = octets copies); false = sortie fermee
+    using FileSink = std::function<bool(const std::filesystem::path&, uintmax_t offset, uintmax_t length,
+                                        uintmax_t& moved)>;
+
+    ArchiveProducer(const std::vector<ArchiveEntry>& entries, int readerThreads,
+                    size_t unitSize, size_t windowUnits);
+
+    // sink renvoie false si la sortie est fermee (compresseur mort).
+    // boundary(prochaine unite) est appele entre deux unites; false = abandon.
+    bool run(const std::function<bool(const char*, size_t)>& sink, const std::atomic<bool>& cancel,
+             size_t firstUnit = 0, const std::function<bool(size_t)>& boundary = nullptr);
+    const ArchiveStats& stats() const { return archiveStats; }
+    // Plafond de lecture des sources (mode arriere-plan), partage entre lecteurs
+    void setReadThrottle(TokenBucket* bucket) { readThrottle = bucket; }
+    // Unites d'au moins minLength octets: le lecteur ne fait que precharger le contenu,
+    // le sequenceur le confie a fileSink (splice) au lieu de le copier dans un buffer
+    void setFileSink(const FileSink& sink, uintmax_t minLength) { fileSink = sink; spliceMin = minLength; }
+
+    // Reperage des unites pour la reprise (nom d'entree + offset dans le fichier)
+    size_t unitCount() const { return units.size(); }
+    size_t findUnit(const std::string& name, uintmax_t offset, uintmax_t size) const;
+    void describeUnit(size_t index, std::string& name, uintmax_t& offset, uintmax_t& size) const;
+
+private:
+    struct Unit {
+        size_t entry;
+        uintmax_t offset;
+        uintmax_t length;
+    };
+
+    void encodeUnit(const Unit& unit, std::vector<char>& out, bool& changed, bool headerOnly) const;
+    bool emitBody(const Unit& unit, const std::function<bool(const char*, size_t)>& sink, bool& changed);
+    bool deferred(const Unit& unit) const { return fileSink && unit.length > 0 && unit.length >= spliceMin; }
+
+    const std::vector<ArchiveEntry>& entries;
+    std::vector<Unit> units;
+    int readerThreads;
+    size_t windowUnits;
+    ArchiveStats archiveStats;
+    TokenBucket* readThrottle = nullptr;
+    FileSink fileSink;
+    uintmax_t spliceMin = 0;
+};
+
+#endif // ARCHIVE_H
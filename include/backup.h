@@ -5,12 +5,33 @@
 #include <vector>
 #include <mutex>
 #include <atomic>
+#include <memory>
+#include <chrono>
+
+#include "process.h"
+#include "config.h"
+#include "estimate.h"
+
+// Resultat de la phase INIT (parcours + estimation), calculable avant l'ordonnancement
+struct JobScan {
+    RuleSet rules;
+    std::vector<ArchiveEntry> entries;
+    std::vector<std::string> unreadable;
+    ArchiveEstimate estimate;
+    std::chrono::steady_clock::time_point scannedAt;
+};
 
 struct BackupJob {
     std::string sourceDir;
+    std::string historyKey; // Chemin canonique: meme dossier = meme entree d'historique
     std::string baseName;
     std::string level;
     int id;
+    bool estimateOnly = false; // --estimate: phase INIT seulement
+    bool backgroundMode = false; // --background: pas de priorite haute
+    int uploadLimitKbit = 0;   // Plafond scp du job (Kbit/s, 0 = illimite)
+    std::vector<Destination> destinations; // Destinations joignables au demarrage
+    std::shared_ptr<const JobScan> scan;   // Parcours deja fait pour l'ordonnancement (nullptr = en INIT)
 };
 
 // Variables globales
@@ -20,8 +41,10 @@ extern std::mutex failedJobsMutex;
 
 // Fonctions principales
 void signalHandler(int signal);
-std::string runCommandWithProgress(const std::string& cmd, int jobId, 
-                                   const std::string& phase, int maxRetries = 3);
-void runBackupJob(BackupJob job, std::string zstdPath, std::string scpPath);
+std::string runCommandWithProgress(const Argv& cmd, int jobId, 
+                                   const std::string& phase, int maxRetries = 3,
+                                   const std::string& label = "");
+std::shared_ptr<JobScan> scanJob(const BackupJob& job, const std::string& zstdPath);
+void runBackupJob(BackupJob job, std::string zstdPath, std::string scpPath, std::string agePath);
 
 #endif // BACKUP_H
@@ -0,0 +1,25 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+#include <cstdint>
+
+// Journal de reprise d'une compression (<archive>.journal)
+struct Checkpoint {
+    std::string sourceDir;
+    uintmax_t archiveOffset = 0; // Fin de la derniere trame zstd complete
+    std::string nextEntry;       // Prochaine unite a produire
+    uintmax_t nextOffset = 0;
+    uintmax_t nextSize = 0;      // Taille du fichier a l'ecriture de son en-tete
+};
+
+bool loadCheckpoint(const std::string& journalPath, Checkpoint& cp);
+bool saveCheckpoint(const std::string& journalPath, const Checkpoint& cp);
+
+// Archive interrompue du meme dossier (journal present) dans le dossier courant
+std::string findResumableArchive(const std::string& baseName, const std::string& ext,
+                                 const std::string& sourceDir);
+
+bool syncFile(const std::string& path);
+
+#endif // CHECKPOINT_H
@@ -2,6 +2,18 @@
 #define CONFIG_H
 
 #include <string>
+#include <vector>
+#include <cstdint>
+
+// Destination distante (user@ip:chemin)
+struct Destination {
+    std::string user;
+    std::string ip;
+    std::string path;
+
+    std::string login() const { return user + "@" + ip; } // Hote ssh
+    std::string target() const { return user + "@" + ip + ":" + path + "/"; } // Cible scp, identifiant dans les logs
+};
 
 // Configuration du serveur distant
 extern std::string REMOTE_USER; 
@@ -9,13 +21,33 @@ extern std::string REMOTE_IP;
 extern std::string REMOTE_PATH; 
 extern std::string DEFAULT_LEVEL; 
 extern std::string SSH_KEY;
+extern std::string UPLOAD_SPEED_MB;   // Debit reseau suppose pour l'estimation (MB/s)
+extern std::string ENCRYPT_RECIPIENT; // Cle publique age (age1.../ssh-...) ou fichier de destinataires
+extern std::vector<Destination> EXTRA_DESTINATIONS; // Cles DESTINATION= supplementaires
+extern std::vector<std::string> INVALID_DESTINATIONS; // Cles DESTINATION= illisibles (signalees par main)
+extern std::vector<std::string> EXCLUDE_RULES;      // Cles EXCLUDE= (syntaxe .gitignore, tous les jobs)
+
+// Mode arriere-plan (BACKGROUND=1 ou --background)
+extern std::string BACKGROUND;
+extern std::string BG_READ_MB;        // Plafond de lecture des sources (MB/s, 0 = illimite)
+extern std::string BG_UPLOAD_MB;      // Plafond d'envoi total (MB/s, 0 = illimite)
+extern std::string BG_PSI_THRESHOLD;  // Seuil de pression IO (%) declenchant le recul, 0 = desactive
+extern std::string BG_CGROUP;         // Repertoire cgroup v2 (optionnel, ex: /sys/fs/cgroup/backstream)
 
 // Optimisations
 const int MAX_PARALLEL_JOBS = 2;
-const size_t PIPE_BUFFER_SIZE = 8192;
+const size_t PIPE_BUFFER_SIZE = 65536;
+const int ARCHIVE_READER_THREADS = 4;               // Lecteurs paralleles du producteur tar
+const size_t ARCHIVE_UNIT_SIZE = 4 * 1024 * 1024;   // Decoupage des gros fichiers
+const size_t ARCHIVE_WINDOW_UNITS = 16;             // Fenetre de reordonnancement (~64 MB)
+const uintmax_t ARCHIVE_SPLICE_MIN = 1024 * 1024;   // Unites envoyees par splice() plutot que copiees
+const uintmax_t CHECKPOINT_INTERVAL = 1ull << 30;   // Octets tar entre deux points de reprise
+const int SCAN_REUSE_SECONDS = 600;                 // Age max d'un parcours prealable reutilise en INIT
 
 bool loadConfig(const std::string& iniPath);
 void saveConfig(const std::string& iniPath); 
 void createConfigInteractive(const std::string& iniPath); 
+bool parseDestination(const std::string& spec, Destination& out);
+std::vector<Destination> getDestinations();
 
 #endif // CONFIG_H
@@ -0,0 +1,28 @@
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "archive.h"
+
+// Estimation pre-vol d'une archive (echantillon stratifie par taille de fichier)
+struct ArchiveEstimate {
+    bool valid = false;
+    uintmax_t rawBytes = 0;       // Taille totale du dossier
+    uintmax_t fileCount = 0;
+    uintmax_t sampledBytes = 0;
+    uintmax_t sampledFiles = 0;
+    uintmax_t archiveBytes = 0;   // Taille extrapolee de l'archive
+    double compressSec = 0;       // Duree extrapolee de la compression
+    double uploadSec = 0;         // Duree extrapolee du transfert
+};
+
+// readThrottle: plafond de lecture des echantillons (mode arriere-plan), attente exclue de la mesure
+ArchiveEstimate estimateArchive(const std::vector<ArchiveEntry>& entries, const std::string& zstdPath,
+                                int level, int threads, TokenBucket* readThrottle = nullptr);
+std::string formatEstimate(const ArchiveEstimate& est);
+std::string formatDuration(double seconds);
+
+#endif // ESTIMATE_H
@@ -0,0 +1,27 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <string>
+#include <cstdint>
+
+// Historique local des durees par dossier source (history.txt a cote de settings.ini)
+struct JobHistory {
+    uintmax_t rawBytes = 0;
+    uintmax_t archiveBytes = 0;
+    double compressSec = 0;
+    double uploadSec = 0;
+    int runs = 0;
+};
+
+bool loadHistory(const std::string& path);
+bool saveHistory(const std::string& path);
+bool findHistory(const std::string& sourceDir, JobHistory& out);
+
+// Mise a jour d'une phase (moyenne glissante avec les executions precedentes)
+void recordCompression(const std::string& sourceDir, uintmax_t rawBytes, uintmax_t archiveBytes, double seconds);
+void recordUpload(const std::string& sourceDir, double seconds);
+
+// Debits moyens observes sur tout l'historique (0 si inconnu)
+void getHistoryRates(double& compressBytesPerSec, double& archiveRatio);
+
+#endif // HISTORY_H
@@ -0,0 +1,43 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+// Tranche de CPU reservee a une compression en cours
+struct CompressionSlot {
+    int id = 0;
+    int threads = 1;
+    std::vector<int> cpus; // Vide = pas d'epinglage
+    bool busy = false;
+};
+
+// Pool de compression partage par tous les jobs: la somme des threads zstd
+// ne depasse jamais le nombre de coeurs, quel que soit le parallelisme.
+// Les CPUs des slots libres sont pretes aux compressions en cours (renegocie a chaque point de reprise).
+class CompressionPool {
+public:
+    void init(int cpuCores, int maxJobs);
+    CompressionSlot acquire();
+    CompressionSlot renegotiate(const CompressionSlot& slot); // Part actuelle du slot occupe
+    void release(const CompressionSlot& slot);
+    int threadsPerSlot();
+
+private:
+    CompressionSlot grantLocked(size_t index) const;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<CompressionSlot> slots;
+};
+
+extern CompressionPool compressionPool;
+
+// Epinglage du thread courant (herite par les processus enfants sous Linux)
+bool pinCurrentThread(const std::vector<int>& cpus);
+void unpinCurrentThread();
+std::string formatCpuList(const std::vector<int>& cpus);
+
+#endif // POOL_H
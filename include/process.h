@@ -0,0 +1,77 @@
+#ifndef PROCESS_H
+#define PROCESS_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+
+#ifndef _WIN32
+    #include <sys/types.h>
+#endif
+
+// Ligne de commande sous forme d'argv explicite (pas de shell sous Linux)
+using Argv = std::vector<std::string>;
+
+// Taille visee pour les pipes entre etages (F_SETPIPE_SZ, Linux)
+const int PIPELINE_PIPE_SIZE = 1 << 20;
+
+Argv splitArgs(const std::string& params);
+std::string quoteCommandLine(const Argv& argv);
+
+// Lance un processus et attend sa fin (quiet: stdout/stderr vers /dev/null)
+int runProcess(const Argv& argv, bool quiet = false);
+
+// BackStream | stage1 | stage2 | ... > outputPath : le flux ecrit alimente le premier etage.
+// outputPath vide: la sortie n'est pas conservee, seule sa taille est comptee (outputBytes)
+class PipelineWriter {
+public:
+    PipelineWriter() = default;
+    PipelineWriter(const PipelineWriter&) = delete;
+    PipelineWriter& operator=(const PipelineWriter&) = delete;
+    ~PipelineWriter();
+
+    bool open(const std::vector<Argv>& stages, const std::string& outputPath, bool append = false);
+    bool write(const char* data, size_t size);
+    // Copie length octets de path (a partir de offset) vers le premier etage.
+    // Linux: splice() fichier -> pipe, sans passer par un buffer utilisateur.
+    // false = sortie fermee; moved < length = fichier raccourci ou illisible
+    bool spliceFrom(const std::string& path, uintmax_t offset, uintmax_t length, uintmax_t& moved);
+    int close(); // Ferme l'entree et attend tous les etages
+    uintmax_t outputBytes() const { return counted; } // Valide apres close()
+
+private:
+    uintmax_t counted = 0;
+#ifdef _WIN32
+    FILE* pipe = nullptr;
+    std::string countPath;
+#else
+    std::vector<pid_t> pids;
+    int fd = -1;
+    std::thread drain;
+#endif
+};
+
+// Lecture du stdout d'un processus enfant
+class ProcessReader {
+public:
+    ProcessReader() = default;
+    ProcessReader(const ProcessReader&) = delete;
+    ProcessReader& operator=(const ProcessReader&) = delete;
+    ~ProcessReader();
+
+    bool open(const Argv& argv);
+    long read(char* buffer, size_t size); // 0 = fin, -1 = erreur
+    int close();                          // Code de retour du processus
+
+private:
+#ifdef _WIN32
+    FILE* pipe = nullptr;
+#else
+    pid_t pid = -1;
+    int fd = -1;
+#endif
+};
+
+#endif // PROCESS_H
@@ -0,0 +1,59 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+// Compteurs par regle (journalises en fin de parcours)
+struct RuleStats {
+    uintmax_t files = 0;
+    uintmax_t dirs = 0;  // Sous-arbres elagues (ni parcourus, ni lus)
+    uintmax_t bytes = 0; // Octets de fichiers evites
+};
+
+// Regles d'exclusion/inclusion facon .gitignore, compilees une fois:
+// noms et chemins litteraux en table de hachage, suffixes (*.tmp) par longueur,
+// motifs generiques en dernier recours. La derniere regle correspondante l'emporte.
+class RuleSet {
+public:
+    void add(const std::string& line);
+    bool empty() const { return rules.empty(); }
+
+    // Indice de la regle decisive, -1 si aucune
+    int match(const std::string& relPath, const std::string& name, bool isDir) const;
+    bool excludes(int rule) const { return rule >= 0 && !rules[rule].negate; }
+
+    void countHit(int rule, bool isDir, uintmax_t bytes);
+    size_t size() const { return rules.size(); }
+    const std::string& pattern(size_t rule) const { return rules[rule].text; }
+    const RuleStats& stats(size_t rule) const { return ruleStats[rule]; }
+
+private:
+    struct Rule {
+        std::string text;  // Ligne d'origine
+        std::string glob;  // Motif normalise
+        bool negate = false;
+        bool dirOnly = false;
+        bool anchored = false;
+    };
+
+    bool accepts(int rule, bool isDir) const { return !rules[rule].dirOnly || isDir; }
+    int bestOf(const std::vector<int>& candidates, bool isDir, int best) const;
+
+    std::vector<Rule> rules;
+    std::vector<RuleStats> ruleStats;
+    std::unordered_map<std::string, std::vector<int>> byName;
+    std::unordered_map<std::string, std::vector<int>> byPath;
+    std::unordered_map<std::string, std::vector<int>> bySuffix;
+    std::vector<size_t> suffixLengths;
+    std::vector<int> globs;
+};
+
+// Regles globales (EXCLUDE= dans settings.ini) puis <source>/.backstreamignore
+RuleSet loadJobRules(const std::string& sourceDir);
+
+bool globMatch(const char* pattern, const char* text);
+
+#endif // RULES_H
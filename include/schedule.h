@@ -0,0 +1,28 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <string>
+#include <vector>
+
+#include "backup.h"
+
+// Durees prevues d'un job, phase par phase
+struct JobPrediction {
+    double compressSec = 0;
+    double uploadSec = 0;
+    bool fromHistory = false;
+};
+
+// Historique du dossier, sinon estimation de job.scan (parcours prealable)
+JobPrediction predictJob(const BackupJob& job);
+
+// Makespan simule: 'slots' jobs en parallele, compression sur sa tranche CPU,
+// uploads concurrents se partageant le debit reseau. startTimes (optionnel): demarrage prevu de chaque job
+double simulateMakespan(const std::vector<JobPrediction>& preds, const std::vector<size_t>& order, int slots,
+                        std::vector<double>* startTimes = nullptr);
+
+// Ordre d'execution retenu parmi plusieurs heuristiques (LPT, Johnson, ordre initial)
+std::vector<size_t> planJobOrder(const std::vector<JobPrediction>& preds, int slots,
+                                 double& predictedMakespan, std::string& strategy);
+
+#endif // SCHEDULE_H
@@ -0,0 +1,43 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Seau a jetons partage entre threads (octets/s, 0 = illimite)
+class TokenBucket {
+public:
+    void setRate(double bytesPerSec);
+    double rate();
+    // Bloque jusqu'a ce que 'bytes' soient autorises (ou annulation)
+    void acquire(uintmax_t bytes, const std::atomic<bool>& cancel);
+
+private:
+    std::mutex mutex;
+    double ratePerSec = 0;
+    double tokens = 0;
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+};
+
+// Debit de lecture des sources (tous jobs confondus)
+extern TokenBucket sourceReadBucket;
+
+// Mode arriere-plan: priorites CPU/IO minimales, heritees par les threads et processus enfants
+bool applyBackgroundPriority();
+// Deplacement du processus dans un cgroup v2 avec des poids CPU/IO faibles.
+// warnings: poids non appliques (controleur cpu/io non delegue), sans empecher le deplacement
+bool joinCgroup(const std::string& cgroupPath, std::string& error, std::vector<std::string>& warnings);
+
+// Pression IO (PSI "some avg10", en %), -1 si indisponible
+double readIoPressure();
+
+// Ajuste sourceReadBucket selon la pression IO: division par 2 au-dessus du seuil,
+// remontee progressive jusqu'a maxRate en dessous de la moitie du seuil
+void startPressureMonitor(double maxRate, double thresholdPct);
+void stopPressureMonitor();
+
+#endif // THROTTLE_H
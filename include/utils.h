@@ -5,6 +5,9 @@
 #include <filesystem>
 #include <vector>
 
+#include "config.h"
+#include "process.h"
+
 // --- CROSS-PLATFORM ---
 #ifdef _WIN32
     #define NOMINMAX
@@ -28,16 +31,18 @@ std::string getAppDir(char* argv0);
 std::string getCurrentDate();
 std::string findScpPath();
 std::string findZstdPath(const std::string& appDir);
+std::string findAgePath(const std::string& appDir);
 
 // Validation
 bool hasEnoughDiskSpace(const std::string& path, uintmax_t requiredBytes);
-bool testSSHConnection(const std::string& scpPath);
+bool testSSHConnection(const std::string& scpPath, const Destination& dest);
 bool isValidLevel(const std::string& s);
 bool looksLikePath(const std::string& s);
 
 // Traitement arguments
 std::string cleanArg(std::string str);
-std::string getOptimalZstdParams(int level, uintmax_t availableRAM);
+std::string getOptimalZstdParams(int level, uintmax_t availableRAM, int threads = 0);
+Argv getAgeParams();
 
 // Pause (Windows & Linux)
 void systemPause();
@@ -0,0 +1,439 @@
+#include "archive.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#ifndef _WIN32
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <pwd.h>
+    #include <grp.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const size_t BLOCK = 512;
+
+// --- Parcours ---
+
+// Nom tar: separateurs '/', sans lecteur ni '/' initial (comme tar -cf)
+std::string toArchiveName(const fs::path& p) {
+    std::string name = p.generic_u8string();
+    if (name.size() >= 2 && name[1] == ':') name.erase(0, 2);
+    size_t first = name.find_first_not_of('/');
+    return first == std::string::npos ? "" : name.substr(first);
+}
+
+// Etat partage par tout le parcours d'un dossier source
+struct ScanState {
+    RuleSet* rules = nullptr;
+    std::vector<std::string>* unreadable = nullptr;
+    std::map<std::pair<uint64_t, uint64_t>, std::string> links; // (st_dev, st_ino) -> premier nom
+    std::map<uint32_t, std::string> users;
+    std::map<uint32_t, std::string> groups;
+};
+
+#ifndef _WIN32
+// getpwuid_r/getgrgid_r: plusieurs jobs parcourent en parallele
+const std::string& userName(ScanState& state, uint32_t uid) {
+    auto it = state.users.find(uid);
+    if (it != state.users.end()) return it->second;
+    struct passwd pw;
+    struct passwd* found = nullptr;
+    std::vector<char> buffer(4096);
+    std::string name;
+    if (getpwuid_r(uid, &pw, buffer.data(), buffer.size(), &found) == 0 && found) name = found->pw_name;
+    return state.users[uid] = name.substr(0, 31);
+}
+
+const std::string& groupName(ScanState& state, uint32_t gid) {
+    auto it = state.groups.find(gid);
+    if (it != state.groups.end()) return it->second;
+    struct group gr;
+    struct group* found = nullptr;
+    std::vector<char> buffer(4096);
+    std::string name;
+    if (getgrgid_r(gid, &gr, buffer.data(), buffer.size(), &found) == 0 && found) name = found->gr_name;
+    return state.groups[gid] = name.substr(0, 31);
+}
+#endif
+
+// e.name doit etre renseigne: il sert de cible aux liens physiques suivants
+bool fillMetadata(ArchiveEntry& e, ScanState& state) {
+#ifndef _WIN32
+    struct stat st;
+    if (lstat(e.path.c_str(), &st) != 0) return false;
+    e.mode = st.st_mode & 07777;
+    e.mtime = st.st_mtime;
+    e.uid = st.st_uid;
+    e.gid = st.st_gid;
+    e.uname = userName(state, e.uid);
+    e.gname = groupName(state, e.gid);
+    if (S_ISDIR(st.st_mode)) e.type = '5';
+    else if (S_ISLNK(st.st_mode)) e.type = '2';
+    else if (S_ISREG(st.st_mode)) e.type = '0';
+    else return false; // fifo, socket, peripherique: ignores
+    e.size = (e.type == '0') ? (uintmax_t)st.st_size : 0;
+    // Liens physiques: contenu stocke une fois, les occurrences suivantes pointent vers la premiere
+    if (e.type == '0' && st.st_nlink > 1) {
+        auto inserted = state.links.emplace(std::make_pair((uint64_t)st.st_dev, (uint64_t)st.st_ino), e.name);
+        if (!inserted.second) {
+            e.type = '1';
+            e.size = 0;
+            e.linkTarget = inserted.first->second;
+        }
+    }
+    if (e.type == '2') {
+        std::error_code ec;
+        e.linkTarget = fs::read_symlink(e.path, ec).generic_u8string();
+        if (ec) return false;
+    }
+    return true;
+#else
+    (void)state;
+    std::error_code ec;
+    fs::file_status st = fs::symlink_status(e.path, ec);
+    if (ec) return false;
+    if (fs::is_directory(st)) e.type = '5';
+    else if (fs::is_regular_file(st)) e.type = '0';
+    else return false;
+    e.mode = (e.type == '5') ? 0755 : 0644;
+    e.size = (e.type == '0') ? fs::file_size(e.path, ec) : 0;
+    if (ec) return false; // Disparu depuis readdir: file_size vaudrait UINTMAX_MAX
+    auto ftime = fs::last_write_time(e.path, ec);
+    if (!ec) {
+        auto sys = std::chrono::time_point_cast<std::chrono::seconds>(
+            ftime - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+        e.mtime = sys.time_since_epoch().count();
+    }
+    return true;
+#endif
+}
+
+// Les regles sont evaluees sur le type lu par readdir: un sous-arbre exclu n'est jamais stat'e ni parcouru
+void walk(const fs::path& dir, const std::string& relDir, std::vector<ArchiveEntry>& out, ScanState& state) {
+    RuleSet* rules = state.rules;
+    std::vector<fs::directory_entry> children;
+    std::error_code ec;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        children.push_back(*it);
+    }
+    // Le dossier reste dans l'archive (vide ou partiel): on le signale
+    if (ec && state.unreadable) state.unreadable->push_back(dir.u8string() + " (" + ec.message() + ")");
+    std::sort(children.begin(), children.end());
+
+    for (const auto& child : children) {
+        std::string name = child.path().filename().generic_u8string();
+        std::string rel = relDir.empty() ? name : relDir + "/" + name;
+
+        if (rules && !rules->empty()) {
+            std::error_code typeEc;
+            bool isDir = child.symlink_status(typeEc).type() == fs::file_type::directory;
+            int rule = rules->match(rel, name, isDir);
+            if (rules->excludes(rule)) {
+                std::error_code sizeEc;
+                uintmax_t bytes = (!isDir && child.is_regular_file(sizeEc)) ? child.file_size(sizeEc) : 0;
+                rules->countHit(rule, isDir, sizeEc ? 0 : bytes);
+                continue;
+            }
+        }
+
+        ArchiveEntry e;
+        e.path = child.path();
+        e.name = toArchiveName(child.path());
+        if (!fillMetadata(e, state)) continue;
+        if (e.type == '5') {
+            e.name += "/";
+            out.push_back(e);
+            walk(child.path(), rel, out, state);
+        } else {
+            out.push_back(e);
+        }
+    }
+}
+
+// --- En-tetes tar (format GNU) ---
+
+void writeOctal(char* field, size_t width, uintmax_t value) {
+    // width-1 chiffres + NUL; au-dela, encodage binaire GNU (base 256)
+    uintmax_t limit = (width - 1) * 3 >= 64 ? UINTMAX_MAX : ((uintmax_t)1 << ((width - 1) * 3)) - 1;
+    if (value <= limit) {
+        std::snprintf(field, width, "%0*llo", (int)(width - 1), (unsigned long long)value);
+        return;
+    }
+    std::memset(field, 0, width);
+    field[0] = (char)0x80;
+    for (size_t i = width - 1; i > 0 && value; --i) {
+        field[i] = (char)(value & 0xff);
+        value >>= 8;
+    }
+}
+
+void encodeHeader(char* h, const std::string& name, char type, uintmax_t size, const ArchiveEntry& e,
+                  const std::string& link) {
+    std::memset(h, 0, BLOCK);
+    std::memcpy(h, name.data(), std::min<size_t>(name.size(), 100));
+    writeOctal(h + 100, 8, e.mode);
+    writeOctal(h + 108, 8, e.uid);
+    writeOctal(h + 116, 8, e.gid);
+    writeOctal(h + 124, 12, size);
+    writeOctal(h + 136, 12, (uintmax_t)std::max<int64_t>(0, e.mtime));
+    h[156] = type;
+    std::memcpy(h + 157, link.data(), std::min<size_t>(link.size(), 100));
+    std::memcpy(h + 257, "ustar  ", 8); // Magic GNU
+    std::memcpy(h + 265, e.uname.data(), std::min<size_t>(e.uname.size(), 31));
+    std::memcpy(h + 297, e.gname.data(), std::min<size_t>(e.gname.size(), 31));
+
+    std::memset(h + 148, ' ', 8);
+    unsigned int sum = 0;
+    for (size_t i = 0; i < BLOCK; ++i) sum += (unsigned char)h[i];
+    std::snprintf(h + 148, 8, "%06o", sum);
+    h[155] = ' ';
+}
+
+// Nom ou cible > 100 caracteres: bloc GNU ././@LongLink ('L' ou 'K')
+void appendLongName(std::vector<char>& out, const std::string& value, char type, const ArchiveEntry& e) {
+    size_t start = out.size();
+    size_t dataLen = value.size() + 1;
+    size_t padded = (dataLen + BLOCK - 1) / BLOCK * BLOCK;
+    out.resize(start + BLOCK + padded, 0);
+    ArchiveEntry meta = e;
+    meta.mode = 0644;
+    encodeHeader(out.data() + start, "././@LongLink", type, dataLen, meta, "");
+    std::memcpy(out.data() + start + BLOCK, value.data(), value.size());
+}
+
+} // namespace
+
+std::vector<ArchiveEntry> scanArchiveEntries(const std::string& sourceDir, RuleSet* rules,
+                                             std::vector<std::string>* unreadable) {
+    std::vector<ArchiveEntry> entries;
+    ScanState state;
+    state.rules = rules;
+    state.unreadable = unreadable;
+    ArchiveEntry root;
+    root.path = fs::path(sourceDir);
+    root.name = toArchiveName(root.path);
+    if (!fillMetadata(root, state)) return entries;
+    if (root.type != '5') {
+        entries.push_back(root);
+        return entries;
+    }
+    root.name += "/";
+    entries.push_back(root);
+    walk(root.path, "", entries, state);
+    return entries;
+}
+
+ArchiveProducer::ArchiveProducer(const std::vector<ArchiveEntry>& entries, int readerThreads,
+                                 size_t unitSize, size_t windowUnits)
+    : entries(entries), readerThreads(std::max(1, readerThreads)), windowUnits(std::max<size_t>(1, windowUnits)) {
+    // Les gros fichiers sont decoupes en unites pour etre lus par plusieurs threads
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const ArchiveEntry& e = entries[i];
+        if (e.type != '0' || e.size == 0) {
+            units.push_back({ i, 0, 0 });
+            continue;
+        }
+        for (uintmax_t off = 0; off < e.size; off += unitSize) {
+            units.push_back({ i, off, std::min<uintmax_t>(unitSize, e.size - off) });
+        }
+    }
+}
+
+void ArchiveProducer::encodeUnit(const Unit& unit, std::vector<char>& out, bool& changed, bool headerOnly) const {
+    const ArchiveEntry& e = entries[unit.entry];
+    out.clear();
+    changed = false;
+
+    // En-tete avec la premiere unite de l'entree
+    if (unit.offset == 0) {
+        if (e.name.size() > 100) appendLongName(out, e.name, 'L', e);
+        if (e.linkTarget.size() > 100) appendLongName(out, e.linkTarget, 'K', e);
+        size_t start = out.size();
+        out.resize(start + BLOCK);
+        encodeHeader(out.data() + start, e.name, e.type, e.size, e, e.linkTarget);
+    }
+    if (unit.length == 0) return;
+
+    // Contenu envoye par le sequenceur (fileSink): lecture anticipee seulement
+    if (headerOnly) {
+#ifndef _WIN32
+        int fd = ::open(e.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            posix_fadvise(fd, (off_t)unit.offset, (off_t)unit.length, POSIX_FADV_WILLNEED);
+            ::close(fd);
+        }
+#endif
+        return;
+    }
+
+    size_t start = out.size();
+    bool lastUnit = unit.offset + unit.length == e.size;
+    size_t padded = lastUnit ? (size_t)((unit.length + BLOCK - 1) / BLOCK * BLOCK) : (size_t)unit.length;
+    out.resize(start + padded, 0);
+
+    std::ifstream in(e.path, std::ios::binary);
+    std::streamsize got = 0;
+    if (in && unit.offset > 0) in.seekg((std::streamoff)unit.offset);
+    if (in) {
+        in.read(out.data() + start, (std::streamsize)unit.length);
+        got = in.gcount();
+    }
+    // Fichier raccourci ou illisible: complete par des zeros pour garder un tar valide
+    if ((uintmax_t)got != unit.length) {
+        std::memset(out.data() + start + got, 0, (size_t)(unit.length - got));
+        changed = true;
+    }
+}
+
+bool ArchiveProducer::emitBody(const Unit& unit, const std::function<bool(const char*, size_t)>& sink,
+                               bool& changed) {
+    const ArchiveEntry& e = entries[unit.entry];
+    uintmax_t moved = 0;
+    if (!fileSink(e.path, unit.offset, unit.length, moved)) return false;
+    archiveStats.bytes += moved;
+
+    // Fichier raccourci ou illisible: zeros jusqu'a la taille annoncee, puis bourrage du dernier bloc
+    uintmax_t missing = unit.length - std::min(moved, unit.length);
+    if (missing > 0) changed = true;
+    if (unit.offset + unit.length == e.size) missing += (BLOCK - e.size % BLOCK) % BLOCK;
+    std::vector<char> zeros((size_t)std::min<uintmax_t>(missing, 64 * BLOCK), 0);
+    while (missing > 0) {
+        size_t n = (size_t)std::min<uintmax_t>(missing, zeros.size());
+        if (!sink(zeros.data(), n)) return false;
+        archiveStats.bytes += n;
+        missing -= n;
+    }
+    return true;
+}
+
+size_t ArchiveProducer::findUnit(const std::string& name, uintmax_t offset, uintmax_t size) const {
+    for (size_t i = 0; i < units.size(); ++i) {
+        const ArchiveEntry& e = entries[units[i].entry];
+        if (units[i].offset == offset && e.name == name) return e.size == size ? i : units.size();
+    }
+    return units.size();
+}
+
+void ArchiveProducer::describeUnit(size_t index, std::string& name, uintmax_t& offset, uintmax_t& size) const {
+    const ArchiveEntry& e = entries[units[index].entry];
+    name = e.name;
+    offset = units[index].offset;
+    size = e.size;
+}
+
+bool ArchiveProducer::run(const std::function<bool(const char*, size_t)>& sink, const std::atomic<bool>& cancel,
+                          size_t firstUnit, const std::function<bool(size_t)>& boundary) {
+    struct Slot {
+        std::vector<char> data; // Buffer recycle d'une unite a l'autre
+        bool ready = false;
+        bool changed = false;
+    };
+
+    std::vector<Slot> slots(windowUnits);
+    std::mutex mutex;
+    std::condition_variable readyCv;  // Unite prete pour le sequenceur
+    std::condition_variable windowCv; // Place libre dans la fenetre
+    size_t nextUnit = firstUnit;
+    size_t emitted = firstUnit;
+    bool stop = false;
+
+    auto reader = [&]() {
+        std::vector<char> buffer;
+        while (true) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                windowCv.wait(lock, [&] { return stop || nextUnit >= units.size() || nextUnit < emitted + windowUnits; });
+                if (stop || nextUnit >= units.size()) return;
+                index = nextUnit++;
+                buffer.swap(slots[index % windowUnits].data);
+            }
+
+            if (readThrottle) readThrottle->acquire(units[index].length, cancel);
+
+            bool changed = false;
+            encodeUnit(units[index], buffer, changed, deferred(units[index]));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Slot& slot = slots[index % windowUnits];
+                slot.data.swap(buffer);
+                slot.changed = changed;
+                slot.ready = true;
+            }
+            readyCv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < readerThreads; ++i) readers.emplace_back(reader);
+
+    // Sequenceur: emission strictement dans l'ordre des unites
+    bool ok = true;
+    std::vector<char> current;
+    for (size_t index = firstUnit; index < units.size(); ++index) {
+        bool changed;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            Slot& slot = slots[index % windowUnits];
+            readyCv.wait(lock, [&] { return slot.ready; });
+            current.swap(slot.data);
+            changed = slot.changed;
+            slot.ready = false;
+        }
+
+        if (cancel || !sink(current.data(), current.size())) {
+            ok = false;
+        } else {
+            archiveStats.bytes += current.size();
+            if (deferred(units[index])) ok = emitBody(units[index], sink, changed);
+        }
+        if (ok) {
+            if (units[index].offset == 0) archiveStats.entries++;
+            // Les unites d'un fichier sont consecutives: un chemin par fichier
+            const std::string& name = entries[units[index].entry].name;
+            if (changed && (archiveStats.changedFiles.empty() || archiveStats.changedFiles.back() != name)) {
+                archiveStats.changedFiles.push_back(name);
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots[index % windowUnits].data.swap(current);
+            emitted = index + 1;
+            if (!ok) stop = true;
+        }
+        windowCv.notify_all();
+        if (!ok) break;
+
+        // Point de coupure possible (checkpoint) entre deux unites
+        if (boundary && index + 1 < units.size() && !boundary(index + 1)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            ok = false;
+            windowCv.notify_all();
+            break;
+        }
+    }
+
+    for (auto& t : readers) t.join();
+    if (!ok) return false;
+
+    // Fin d'archive: deux blocs nuls
+    std::vector<char> trailer(2 * BLOCK, 0);
+    if (!sink(trailer.data(), trailer.size())) return false;
+    archiveStats.bytes += trailer.size();
+    return true;
+}
@@ -2,18 +2,16 @@
 #include "config.h"
 #include "utils.h"
 #include "progress.h"
+#include "pool.h"
+#include "estimate.h"
+#include "archive.h"
+#include "checkpoint.h"
+#include "history.h"
+#include "throttle.h"
 
 // --- CROSS-PLATFORM ---
 #ifdef _WIN32
     #include <windows.h>
-    #include <io.h>
-    #define POPEN _popen
-    #define PCLOSE _pclose
-#else
-    #include <unistd.h>
-    #define POPEN popen
-    #define PCLOSE pclose
-    #include <sys/wait.h> // Pour WEXITSTATUS
 #endif
 // ---------------------------------
 
@@ -23,6 +21,10 @@
 #include <chrono>
 #include <filesystem>
 #include <sstream>
+#include <fstream>
+#include <future>
+#include <set>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 using namespace std::chrono;
@@ -38,97 +40,149 @@ void signalHandler(int signal) {
     }
 }
 
-std::string runCommandWithProgress(const std::string& cmd, int jobId, 
-                                   const std::string& phase, int maxRetries) {
+// Destinations deja servies lors d'une execution precedente (fichier <archive>.sent)
+static std::set<std::string> loadSentDestinations(const std::string& sentPath) {
+    std::set<std::string> sent;
+    std::ifstream file(sentPath);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) sent.insert(line);
+    }
+    return sent;
+}
+
+// Bilan des exclusions: une ligne par regle ayant servi
+static void logRuleStats(int jobId, const RuleSet& rules) {
+    uintmax_t totalBytes = 0;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const RuleStats& st = rules.stats(i);
+        if (st.files == 0 && st.dirs == 0) continue;
+        totalBytes += st.bytes;
+        log(jobId, "INIT", "Regle '" + rules.pattern(i) + "': " + std::to_string(st.files) + " fichier(s), "
+            + std::to_string(st.dirs) + " dossier(s) elague(s), " + std::to_string(st.bytes / (1024 * 1024)) + " MB evites");
+    }
+    if (totalBytes > 0) {
+        log(jobId, "INIT", "Exclusions: " + std::to_string(totalBytes / (1024 * 1024)) + " MB evites (hors dossiers elagues)");
+    }
+}
+
+std::string runCommandWithProgress(const Argv& cmd, int jobId, 
+                                   const std::string& phase, int maxRetries,
+                                   const std::string& label) {
     static const std::regex percentRegex(R"((\d+)%)");
     static const std::regex scpSpeedRegex(R"((\d+)%\s+\S+\s+([\d.]+[KMG]B/s))");
+    std::string prefix = label.empty() ? "" : label + " - ";
     
     for (int attempt = 1; attempt <= maxRetries; ++attempt) {
         if (programInterrupted) return "INTERRUPTED";
         
         if (attempt > 1) {
-            log(jobId, phase, "Tentative " + std::to_string(attempt) + "/" + std::to_string(maxRetries));
+            log(jobId, phase, prefix + "Tentative " + std::to_string(attempt) + "/" + std::to_string(maxRetries));
             std::this_thread::sleep_for(std::chrono::seconds(5));
         }
         
-        FILE* pipe = POPEN(cmd.c_str(), "r");
-        if (!pipe) {
-            log(jobId, phase, "Erreur: impossible d'ouvrir le pipe");
+        ProcessReader process;
+        if (!process.open(cmd)) {
+            log(jobId, phase, prefix + "Erreur: impossible d'ouvrir le pipe");
             if (attempt == maxRetries) return "PIPE_FAILED";
             continue;
         }
         
-        char buffer[PIPE_BUFFER_SIZE];
+        std::vector<char> buffer(PIPE_BUFFER_SIZE);
         std::string output;
-        // output.reserve(4096); 
+        std::string line;
         int lastPercent = -1;
         
-        while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+        long n;
+        while ((n = process.read(buffer.data(), buffer.size())) > 0) {
             if (programInterrupted) {
-                PCLOSE(pipe);
+                process.close();
                 return "INTERRUPTED";
             }
             
-            std::string line(buffer);
-            output += line;
+            output.append(buffer.data(), (size_t)n);
+            
+            // Decoupage en lignes (scp rafraichit sa progression avec \r)
+            for (long i = 0; i < n; ++i) {
+                char c = buffer[i];
+                if (c != '\n' && c != '\r') { line += c; continue; }
+                if (line.empty()) continue;
             
-            if (phase == "UPLOAD") {
-                std::smatch match;
-                if (std::regex_search(line, match, scpSpeedRegex)) {
-                    int pct = std::stoi(match[1]);
-                    std::string speed = match[2].str();
-                    if (pct % 10 == 0 && pct != lastPercent) {
-                        log(jobId, phase, std::to_string(pct) + "% - " + speed);
-                        lastPercent = pct;
+                if (phase == "UPLOAD") {
+                    std::smatch match;
+                    if (std::regex_search(line, match, scpSpeedRegex)) {
+                        int pct = std::stoi(match[1]);
+                        std::string speed = match[2].str();
+                        if (pct % 10 == 0 && pct != lastPercent) {
+                            log(jobId, phase, prefix + std::to_string(pct) + "% - " + speed);
+                            lastPercent = pct;
+                        }
                     }
-                }
-                else if (std::regex_search(line, match, percentRegex)) {
-                    int pct = std::stoi(match[1]);
-                    if (pct % 10 == 0 && pct != lastPercent) {
-                        log(jobId, phase, std::to_string(pct) + "%");
-                        lastPercent = pct;
+                    else if (std::regex_search(line, match, percentRegex)) {
+                        int pct = std::stoi(match[1]);
+                        if (pct % 10 == 0 && pct != lastPercent) {
+                            log(jobId, phase, prefix + std::to_string(pct) + "%");
+                            lastPercent = pct;
+                        }
                     }
                 }
+                line.clear();
             }
         }
         
-        int result = PCLOSE(pipe);
-        
-        // Sur Linux, il faut extraire le vrai code de retour
-        #ifndef _WIN32
-        if (WIFEXITED(result)) result = WEXITSTATUS(result);
-        #endif
+        int result = process.close();
 
         if (result == 0) {
             return output;
         }
         
         if (attempt < maxRetries && phase == "UPLOAD") {
-            log(jobId, phase, "Echec (code " + std::to_string(result) + "), nouvelle tentative...");
+            log(jobId, phase, prefix + "Echec (code " + std::to_string(result) + "), nouvelle tentative...");
         }
     }
     
     return "FAILED_AFTER_RETRIES";
 }
 
-void runBackupJob(BackupJob job, std::string zstdPath, std::string scpPath) {
-    // Thread Priority (Windows seulement)
+std::shared_ptr<JobScan> scanJob(const BackupJob& job, const std::string& zstdPath) {
+    auto scan = std::make_shared<JobScan>();
+    scan->scannedAt = steady_clock::now();
+    scan->rules = loadJobRules(job.sourceDir);
+    scan->entries = scanArchiveEntries(job.sourceDir, &scan->rules, &scan->unreadable);
+    scan->estimate = estimateArchive(scan->entries, zstdPath, std::stoi(job.level), compressionPool.threadsPerSlot(),
+                                     job.backgroundMode ? &sourceReadBucket : nullptr);
+    return scan;
+}
+
+void runBackupJob(BackupJob job, std::string zstdPath, std::string scpPath, std::string agePath) {
+    // Thread Priority (Windows seulement, hors mode arriere-plan)
     #ifdef _WIN32
-    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+    if (!job.backgroundMode) SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
     #endif
     
-    std::string pathToZstd = "\"" + zstdPath + "\"";
     std::string dateStr = getCurrentDate();
-    std::string archiveName = job.baseName + "_" + dateStr + ".tar.zst";
+    bool encrypt = !agePath.empty();
+    std::string ext = encrypt ? ".tar.zst.age" : ".tar.zst";
+    std::string archiveName = job.baseName + "_" + dateStr + ext;
     
-    if (fs::exists(archiveName)) {
-        archiveName = job.baseName + "_" + std::to_string(job.id) + "_" + dateStr + ".tar.zst";
+    // Compression interrompue lors d'un lancement precedent: on reprend la meme archive
+    std::string resumable = findResumableArchive(job.baseName, ext, job.sourceDir);
+    if (!resumable.empty()) {
+        archiveName = resumable;
+    }
+    // Une archive accompagnee de son fichier .sent est un upload a reprendre
+    else if (fs::exists(archiveName) && !fs::exists(archiveName + ".sent")) {
+        archiveName = job.baseName + "_" + std::to_string(job.id) + "_" + dateStr + ext;
     }
     
     fs::path absArchivePath = fs::absolute(archiveName);
     std::string absArchiveStr = absArchivePath.string();
+    std::string journalPath = absArchiveStr + ".journal";
     
     log(job.id, "INIT", "Demarrage backup: " + job.sourceDir);
+    if (encrypt) {
+        log(job.id, "INIT", "Archive chiffree (age): pas de point de reprise, une interruption relance la compression depuis le debut");
+    }
     
     if (!fs::exists(job.sourceDir)) {
         log(job.id, "ERROR", "Dossier introuvable: " + job.sourceDir);
@@ -138,18 +192,42 @@ void runBackupJob(BackupJob job, std::string zstdPath, std::string scpPath) {
     }
     
     uintmax_t dirSize = 0;
-    try {
-        log(job.id, "INIT", "Calcul de la taille du dossier...");
-        for (const auto& entry : fs::recursive_directory_iterator(job.sourceDir)) {
-            if (fs::is_regular_file(entry)) dirSize += fs::file_size(entry);
-        }
+    // Parcours unique: sert a l'estimation puis au producteur tar.
+    // Celui fait pour l'ordonnancement est repris s'il est recent (sinon le dossier a pu changer)
+    std::shared_ptr<const JobScan> scan = job.scan;
+    if (scan && steady_clock::now() - scan->scannedAt > seconds(SCAN_REUSE_SECONDS)) {
+        log(job.id, "INIT", "Parcours prealable trop ancien, nouveau parcours");
+        scan = nullptr;
+    }
+    if (!scan) {
+        log(job.id, "INIT", "Calcul de la taille du dossier et echantillonnage...");
+        scan = scanJob(job, zstdPath);
+    }
+    const std::vector<ArchiveEntry>& entries = scan->entries;
+    const ArchiveEstimate& estimate = scan->estimate;
+    for (const auto& dir : scan->unreadable) {
+        log(job.id, "WARN", "Dossier illisible, contenu absent de l'archive: " + dir);
+    }
+    logRuleStats(job.id, scan->rules);
+    if (!entries.empty()) {
+        dirSize = estimate.rawBytes;
         double sizeGB = dirSize / (1024.0 * 1024.0 * 1024.0);
-        log(job.id, "INIT", "Taille totale: " + std::to_string((int)sizeGB) + " GB");
-    } catch (const std::exception&) {
+        log(job.id, "INIT", "Taille totale: " + std::to_string((int)sizeGB) + " GB (" + std::to_string(estimate.fileCount) + " fichiers)");
+    } else {
         log(job.id, "WARN", "Impossible de calculer la taille");
     }
+    if (estimate.valid && dirSize > 0) {
+        log(job.id, "INIT", formatEstimate(estimate));
+    }
+
+    if (job.estimateOnly) {
+        log(job.id, "DONE", "Estimation terminee (aucune archive creee)");
+        return;
+    }
     
-    if (dirSize > 0 && !hasEnoughDiskSpace(".", dirSize)) {
+    // Verification sur la taille estimee de l'archive (taille brute si l'estimation a echoue)
+    uintmax_t requiredBytes = estimate.valid ? estimate.archiveBytes : dirSize;
+    if (dirSize > 0 && !hasEnoughDiskSpace(".", requiredBytes)) {
         log(job.id, "ERROR", "Espace disque insuffisant");
         std::lock_guard<std::mutex> lock(failedJobsMutex);
         failedJobs.push_back("JOB " + std::to_string(job.id) + ": Espace disque insuffisant");
@@ -158,91 +236,257 @@ void runBackupJob(BackupJob job, std::string zstdPath, std::string scpPath) {
 
     // COMPRESSION
     bool skipCompression = false;
-    if (fs::exists(absArchivePath) && fs::file_size(absArchivePath) > 0) {
+    if (!fs::exists(journalPath) && fs::exists(absArchivePath) && fs::file_size(absArchivePath) > 0) {
         log(job.id, "COMPRESS", "Archive existe deja, skip compression");
         skipCompression = true;
     }
 
     if (!skipCompression) {
+        // Attente d'une tranche du pool partage (budget CPU borne entre jobs)
+        CompressionSlot slot = compressionPool.acquire();
+        bool pinned = pinCurrentThread(slot.cpus);
+
         uintmax_t ram = getAvailableRAM();
-        std::string zstdParams = getOptimalZstdParams(std::stoi(job.level), ram);
-        
-        log(job.id, "COMPRESS", "Debut compression (niveau " + job.level + ")");
         
-        // --- COMMANDE HYBRIDE ---
-        std::string finalCmd;
-        #ifdef _WIN32
-            // Windows : On passe par cmd.exe pour gérer le pipe |
-            std::string innerCmd = "tar -cf - \"" + job.sourceDir + "\" 2>nul | " + pathToZstd + " " + zstdParams + " -q -o \"" + absArchiveStr + "\"";
-            finalCmd = "cmd.exe /c \"" + innerCmd + "\"";
-        #else
-            // Linux : Le shell par défaut gère le pipe, tar gère les erreurs via stderr
-            finalCmd = "tar -cf - \"" + job.sourceDir + "\" 2>/dev/null | " + pathToZstd + " " + zstdParams + " -q -o \"" + absArchiveStr + "\"";
-        #endif
+        log(job.id, "COMPRESS", "Debut compression (niveau " + job.level + ", " + std::to_string(slot.threads) + " threads"
+            + (pinned ? ", CPUs " + formatCpuList(slot.cpus) : "") + ")");
+
+        // Etage de chiffrement optionnel entre zstd et le fichier final (pas de seconde passe).
+        // Des flux age concatenes ne se dechiffrent pas d'un bloc: pas de points de reprise.
+        bool checkpointing = !encrypt;
+        if (encrypt) {
+            log(job.id, "COMPRESS", "Chiffrement en flux (age) - reprise sur interruption desactivee");
+        }
+
+        // Producteur tar interne | zstd [| age] > archive, sur la part actuelle du pool
+        auto buildStages = [&]() {
+            Argv zstdCmd = { zstdPath };
+            Argv params = splitArgs(getOptimalZstdParams(std::stoi(job.level), ram, slot.threads));
+            zstdCmd.insert(zstdCmd.end(), params.begin(), params.end());
+            zstdCmd.insert(zstdCmd.end(), { "-q", "-c" });
+
+            std::vector<Argv> stages = { zstdCmd };
+            if (encrypt) {
+                Argv ageCmd = { agePath };
+                Argv ageParams = getAgeParams();
+                ageCmd.insert(ageCmd.end(), ageParams.begin(), ageParams.end());
+                stages.push_back(ageCmd);
+            }
+            return stages;
+        };
+
+        ArchiveProducer producer(entries, ARCHIVE_READER_THREADS, ARCHIVE_UNIT_SIZE, ARCHIVE_WINDOW_UNITS);
+        if (job.backgroundMode) producer.setReadThrottle(&sourceReadBucket);
+        Checkpoint cp;
+        size_t firstUnit = 0;
+
+        // Reprise: troncature a la derniere trame complete, puis suite du flux tar
+        if (fs::exists(journalPath)) {
+            if (checkpointing && loadCheckpoint(journalPath, cp) && cp.sourceDir == job.sourceDir
+                && fs::file_size(absArchivePath) >= cp.archiveOffset) {
+                firstUnit = producer.findUnit(cp.nextEntry, cp.nextOffset, cp.nextSize);
+            }
+            if (firstUnit > 0 && firstUnit < producer.unitCount()) {
+                fs::resize_file(absArchivePath, cp.archiveOffset);
+                log(job.id, "COMPRESS", "Reprise a " + std::to_string(cp.archiveOffset / (1024 * 1024))
+                    + " MB depuis: " + cp.nextEntry);
+            } else {
+                firstUnit = 0;
+                fs::remove(journalPath);
+                log(job.id, "WARN", "Journal de reprise inutilisable (dossier modifie?), compression complete");
+            }
+        }
+        cp.sourceDir = job.sourceDir;
 
         auto startComp = steady_clock::now();
-        int res = std::system(finalCmd.c_str());
+        int res = -1;
+        PipelineWriter compressor;
+        // Seuls les etages enfants sont epingles: les lecteurs du producteur gardent
+        // le masque du processus et ne prennent pas sur les threads zstd (-T)
+        auto openCompressor = [&](bool append) {
+            if (pinned) pinCurrentThread(slot.cpus);
+            bool opened = compressor.open(buildStages(), absArchiveStr, append);
+            if (pinned) unpinCurrentThread();
+            return opened;
+        };
+        if (openCompressor(firstUnit > 0)) {
+            uintmax_t segmentBytes = 0;
+            auto sink = [&](const char* data, size_t size) {
+                segmentBytes += size;
+                return compressor.write(data, size);
+            };
+            // Corps des gros fichiers: fichier -> pipe zstd sans copie en espace utilisateur
+            producer.setFileSink([&](const fs::path& path, uintmax_t offset, uintmax_t length, uintmax_t& moved) {
+                bool ok = compressor.spliceFrom(path.string(), offset, length, moved);
+                segmentBytes += moved;
+                return ok;
+            }, ARCHIVE_SPLICE_MIN);
+
+            // Toutes les CHECKPOINT_INTERVAL octets: fin de trame zstd, fsync, journal, nouvelle trame
+            auto checkpoint = [&](size_t nextUnit) {
+                if (!checkpointing || segmentBytes < CHECKPOINT_INTERVAL) return true;
+                if (compressor.close() != 0 || !syncFile(absArchiveStr)) return false;
+                cp.archiveOffset = fs::file_size(absArchivePath);
+                producer.describeUnit(nextUnit, cp.nextEntry, cp.nextOffset, cp.nextSize);
+                if (!saveCheckpoint(journalPath, cp)) return false;
+                segmentBytes = 0;
+
+                // Nouvelle trame: part du pool recalculee (compressions demarrees ou terminees entre-temps)
+                CompressionSlot grant = compressionPool.renegotiate(slot);
+                if (grant.threads != slot.threads) {
+                    log(job.id, "COMPRESS", "Threads zstd: " + std::to_string(slot.threads) + " -> "
+                        + std::to_string(grant.threads) + (pinned ? " (CPUs " + formatCpuList(grant.cpus) + ")" : ""));
+                }
+                slot = grant;
+                return openCompressor(true);
+            };
+
+            bool produced = producer.run(sink, programInterrupted, firstUnit, checkpoint);
+            res = compressor.close();
+            if (!produced && res == 0) res = -1;
+
+            // Taille conservee, contenu manquant remplace par des zeros: a signaler fichier par fichier
+            const auto& changed = producer.stats().changedFiles;
+            for (const auto& name : changed) {
+                log(job.id, "WARN", "Fichier modifie ou illisible pendant la lecture (complete par des zeros): " + name);
+            }
+            if (!changed.empty()) {
+                log(job.id, "WARN", std::to_string(changed.size()) + " fichier(s) incomplet(s) dans l'archive");
+            }
+        }
         auto endComp = steady_clock::now();
-        
-        // Décodage du code retour Linux
-        #ifndef _WIN32
-        if (WIFEXITED(res)) res = WEXITSTATUS(res);
-        #endif
 
+        if (pinned) unpinCurrentThread();
+        compressionPool.release(slot);
+        
         auto durationSec = duration_cast<seconds>(endComp - startComp).count();
         
         if (programInterrupted) {
             log(job.id, "ERROR", "Interruption detectee");
-            if (fs::exists(absArchivePath)) fs::remove(absArchivePath);
+            if (fs::exists(journalPath)) {
+                log(job.id, "INFO", "Archive partielle conservee pour reprise: " + absArchiveStr);
+            } else if (fs::exists(absArchivePath)) {
+                fs::remove(absArchivePath);
+            }
             return;
         }
         
         if (res != 0 || !fs::exists(absArchivePath) || fs::file_size(absArchivePath) == 0) {
             log(job.id, "ERROR", "Echec compression (code: " + std::to_string(res) + ")");
             if (fs::exists(absArchivePath)) fs::remove(absArchivePath);
+            if (fs::exists(journalPath)) fs::remove(journalPath);
             std::lock_guard<std::mutex> lock(failedJobsMutex);
             failedJobs.push_back("JOB " + std::to_string(job.id) + ": Echec compression");
             return;
         }
         
+        if (fs::exists(journalPath)) fs::remove(journalPath);
+
         uintmax_t archiveSize = fs::file_size(absArchivePath);
         double archiveSizeGB = archiveSize / (1024.0 * 1024.0 * 1024.0);
         double ratio = (dirSize > 0) ? (100.0 * archiveSize / dirSize) : 0;
+
+        // Une compression reprise ou bridee (arriere-plan) fausserait la duree de reference
+        if (firstUnit == 0 && !job.backgroundMode) {
+            recordCompression(job.historyKey, dirSize, archiveSize, duration<double>(endComp - startComp).count());
+        }
         
         log(job.id, "COMPRESS", "Termine en " + std::to_string(durationSec) + "s - " 
             + std::to_string((int)archiveSizeGB) + " GB (ratio: " + std::to_string((int)ratio) + "%)");
     }
 
-    // UPLOAD SCP
-    log(job.id, "UPLOAD", "Debut transfert vers " + REMOTE_IP);
-    
-    std::string remoteTarget = REMOTE_USER + "@" + REMOTE_IP + ":" + REMOTE_PATH + "/";
-    std::string scpCmd = scpPath + " -i " + SSH_KEY + " \"" + absArchiveStr + "\" " + remoteTarget;
-    
-    auto startUpload = steady_clock::now();
-    std::string scpResult = runCommandWithProgress(scpCmd, job.id, "UPLOAD", 3);
-    auto endUpload = steady_clock::now();
-    
-    if (scpResult == "INTERRUPTED" || programInterrupted) {
+    // UPLOAD SCP (une archive, N destinations en parallele)
+    std::vector<Destination> destinations = getDestinations();
+    std::string sentPath = absArchiveStr + ".sent";
+    std::set<std::string> alreadySent = loadSentDestinations(sentPath);
+    std::ofstream(sentPath, std::ios::app).close();
+
+    // Une destination injoignable au demarrage reste hors de .sent: la prochaine execution la reessaie
+    std::vector<Destination> pending;
+    std::vector<std::string> failedDests;
+    for (const auto& dest : destinations) {
+        bool reachable = std::any_of(job.destinations.begin(), job.destinations.end(),
+            [&](const Destination& d) { return d.target() == dest.target(); });
+        if (alreadySent.count(dest.target())) {
+            log(job.id, "UPLOAD", dest.target() + " - Deja transfere, skip");
+        } else if (!reachable) {
+            log(job.id, "WARN", dest.target() + " - Injoignable, transfert reporte a la prochaine execution");
+            failedDests.push_back(dest.target());
+        } else {
+            pending.push_back(dest);
+        }
+    }
+
+    std::mutex sentMutex;
+    auto uploadTo = [&](const Destination& dest) -> std::string {
+        log(job.id, "UPLOAD", "Debut transfert vers " + dest.target());
+
+        Argv scpCmd = { scpPath, "-i", SSH_KEY };
+        if (job.uploadLimitKbit > 0) {
+            // Plafond du job partage entre ses destinations simultanees
+            int limit = std::max(1, job.uploadLimitKbit / (int)pending.size());
+            scpCmd.insert(scpCmd.end(), { "-l", std::to_string(limit) });
+        }
+        scpCmd.insert(scpCmd.end(), { absArchiveStr, dest.target() });
+
+        auto startUpload = steady_clock::now();
+        std::string scpResult = runCommandWithProgress(scpCmd, job.id, "UPLOAD", 3, dest.target());
+        auto endUpload = steady_clock::now();
+
+        if (scpResult == "INTERRUPTED" || programInterrupted) return "INTERRUPTED";
+        if (scpResult == "FAILED_AFTER_RETRIES" || scpResult == "PIPE_FAILED") {
+            log(job.id, "ERROR", dest.target() + " - Echec transfert apres 3 tentatives");
+            return "FAILED";
+        }
+
+        auto uploadDurationSec = duration_cast<seconds>(endUpload - startUpload).count();
+        log(job.id, "UPLOAD", dest.target() + " - Termine en " + std::to_string(uploadDurationSec) + "s");
+
+        // Etat de reprise: une ligne par destination terminee
+        std::lock_guard<std::mutex> lock(sentMutex);
+        std::ofstream sent(sentPath, std::ios::app);
+        sent << dest.target() << "\n";
+        return "OK";
+    };
+
+    // Chaque scp lit l'archive locale a son rythme: une destination lente ne bloque pas les autres
+    auto startUploads = steady_clock::now();
+    std::vector<std::future<std::string>> uploads;
+    for (const auto& dest : pending) {
+        uploads.push_back(std::async(std::launch::async, uploadTo, dest));
+    }
+
+    bool interrupted = false;
+    for (size_t i = 0; i < uploads.size(); ++i) {
+        std::string res = uploads[i].get();
+        if (res == "INTERRUPTED") interrupted = true;
+        else if (res != "OK") failedDests.push_back(pending[i].target());
+    }
+
+    if (interrupted || programInterrupted) {
         log(job.id, "ERROR", "Transfert interrompu");
         log(job.id, "INFO", "Archive conservee: " + absArchiveStr);
         return;
     }
-    
-    if (scpResult == "FAILED_AFTER_RETRIES" || scpResult == "PIPE_FAILED") {
-        log(job.id, "ERROR", "Echec transfert apres 3 tentatives");
+
+    // Duree de la phase complete (la destination la plus lente), si toutes ont ete servies
+    if (failedDests.empty() && pending.size() == destinations.size() && !pending.empty() && job.uploadLimitKbit == 0) {
+        recordUpload(job.historyKey, duration<double>(steady_clock::now() - startUploads).count());
+    }
+
+    if (!failedDests.empty()) {
+        std::string list;
+        for (const auto& target : failedDests) list += (list.empty() ? "" : ", ") + target;
         log(job.id, "INFO", "Archive conservee: " + absArchiveStr);
         std::lock_guard<std::mutex> lock(failedJobsMutex);
-        failedJobs.push_back("JOB " + std::to_string(job.id) + ": Echec upload SCP");
+        failedJobs.push_back("JOB " + std::to_string(job.id) + ": Upload incomplet (" + list + ")");
         return;
     }
 
-    auto uploadDurationSec = duration_cast<seconds>(endUpload - startUpload).count();
-    log(job.id, "UPLOAD", "Termine en " + std::to_string(uploadDurationSec) + "s");
-
     // NETTOYAGE
     try {
         fs::remove(absArchivePath);
+        if (fs::exists(sentPath)) fs::remove(sentPath);
         log(job.id, "CLEANUP", "Archive locale supprimee");
     } catch (const std::exception&) {
         log(job.id, "WARN", "Impossible de supprimer l'archive: " + absArchiveStr);
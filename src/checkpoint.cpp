@@ -0,0 +1,92 @@
+#include "checkpoint.h"
+
+#include <fstream>
+#include <filesystem>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+bool syncFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    bool ok = FlushFileBuffers(h) != 0;
+    CloseHandle(h);
+    return ok;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+bool loadCheckpoint(const std::string& journalPath, Checkpoint& cp) {
+    std::ifstream file(journalPath);
+    if (!file.is_open()) return false;
+
+    bool hasOffset = false;
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t pos = line.find('=');
+        if (pos == std::string::npos) continue;
+        std::string key = line.substr(0, pos);
+        std::string value = line.substr(pos + 1);
+        try {
+            if (key == "source") cp.sourceDir = value;
+            else if (key == "archive_offset") { cp.archiveOffset = std::stoull(value); hasOffset = true; }
+            else if (key == "next_entry") cp.nextEntry = value;
+            else if (key == "next_offset") cp.nextOffset = std::stoull(value);
+            else if (key == "next_size") cp.nextSize = std::stoull(value);
+        } catch (...) {
+            return false;
+        }
+    }
+    return hasOffset && !cp.nextEntry.empty();
+}
+
+// Ecriture atomique: fichier temporaire synchronise puis renomme
+bool saveCheckpoint(const std::string& journalPath, const Checkpoint& cp) {
+    std::string tmpPath = journalPath + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file.is_open()) return false;
+        file << "source=" << cp.sourceDir << "\n";
+        file << "archive_offset=" << cp.archiveOffset << "\n";
+        file << "next_entry=" << cp.nextEntry << "\n";
+        file << "next_offset=" << cp.nextOffset << "\n";
+        file << "next_size=" << cp.nextSize << "\n";
+        if (!file.good()) return false;
+    }
+    if (!syncFile(tmpPath)) return false;
+
+    std::error_code ec;
+    fs::rename(tmpPath, journalPath, ec);
+    return !ec;
+}
+
+std::string findResumableArchive(const std::string& baseName, const std::string& ext,
+                                 const std::string& sourceDir) {
+    std::string suffix = ext + ".journal";
+    std::error_code ec;
+    for (fs::directory_iterator it(".", ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.size() <= suffix.size() || name.rfind(baseName + "_", 0) != 0) continue;
+        if (name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) continue;
+
+        Checkpoint cp;
+        std::string archive = name.substr(0, name.size() - std::string(".journal").size());
+        if (loadCheckpoint(it->path().string(), cp) && cp.sourceDir == sourceDir && fs::exists(archive)) {
+            return archive;
+        }
+    }
+    return "";
+}
@@ -11,6 +11,16 @@ std::string REMOTE_IP = "";
 std::string REMOTE_PATH = "";
 std::string SSH_KEY = "";
 std::string DEFAULT_LEVEL = "3";
+std::string UPLOAD_SPEED_MB = "100";
+std::string ENCRYPT_RECIPIENT = "";
+std::vector<Destination> EXTRA_DESTINATIONS;
+std::vector<std::string> INVALID_DESTINATIONS;
+std::vector<std::string> EXCLUDE_RULES;
+std::string BACKGROUND = "0";
+std::string BG_READ_MB = "50";
+std::string BG_UPLOAD_MB = "20";
+std::string BG_PSI_THRESHOLD = "10";
+std::string BG_CGROUP = "";
 
 std::string trim(const std::string& str) {
     size_t first = str.find_first_not_of(" \t\r\n");
@@ -39,6 +49,19 @@ bool loadConfig(const std::string& iniPath) {
             else if (key == "REMOTE_PATH") REMOTE_PATH = value;
             else if (key == "SSH_KEY") SSH_KEY = value;
             else if (key == "DEFAULT_LEVEL") DEFAULT_LEVEL = value;
+            else if (key == "UPLOAD_SPEED_MB") UPLOAD_SPEED_MB = value;
+            else if (key == "ENCRYPT_RECIPIENT") ENCRYPT_RECIPIENT = value;
+            else if (key == "EXCLUDE") EXCLUDE_RULES.push_back(value);
+            else if (key == "BACKGROUND") BACKGROUND = value;
+            else if (key == "BG_READ_MB") BG_READ_MB = value;
+            else if (key == "BG_UPLOAD_MB") BG_UPLOAD_MB = value;
+            else if (key == "BG_PSI_THRESHOLD") BG_PSI_THRESHOLD = value;
+            else if (key == "BG_CGROUP") BG_CGROUP = value;
+            else if (key == "DESTINATION") {
+                Destination dest;
+                if (parseDestination(value, dest)) EXTRA_DESTINATIONS.push_back(dest);
+                else INVALID_DESTINATIONS.push_back(value);
+            }
         }
     }
     return true;
@@ -53,6 +76,21 @@ void saveConfig(const std::string& iniPath) {
         file << "REMOTE_PATH=" << REMOTE_PATH << "\n";
         file << "SSH_KEY=" << SSH_KEY << "\n";
         file << "DEFAULT_LEVEL=" << DEFAULT_LEVEL << "\n";
+        file << "UPLOAD_SPEED_MB=" << UPLOAD_SPEED_MB << "\n";
+        if (!ENCRYPT_RECIPIENT.empty()) file << "ENCRYPT_RECIPIENT=" << ENCRYPT_RECIPIENT << "\n";
+        if (BACKGROUND == "1") {
+            file << "BACKGROUND=1\n";
+            file << "BG_READ_MB=" << BG_READ_MB << "\n";
+            file << "BG_UPLOAD_MB=" << BG_UPLOAD_MB << "\n";
+            file << "BG_PSI_THRESHOLD=" << BG_PSI_THRESHOLD << "\n";
+            if (!BG_CGROUP.empty()) file << "BG_CGROUP=" << BG_CGROUP << "\n";
+        }
+        for (const auto& rule : EXCLUDE_RULES) {
+            file << "EXCLUDE=" << rule << "\n";
+        }
+        for (const auto& dest : EXTRA_DESTINATIONS) {
+            file << "DESTINATION=" << dest.user << "@" << dest.ip << ":" << dest.path << "\n";
+        }
     }
 }
 
@@ -89,4 +127,26 @@ void createConfigInteractive(const std::string& iniPath) {
     std::cout << "\n>> Sauvegarde de la configuration dans settings.ini...\n";
     saveConfig(iniPath);
     std::cout << ">> Configuration terminee !\n\n";
-}
\ No newline at end of file
+}
+
+// Format attendu: user@ip:/chemin/distant
+bool parseDestination(const std::string& spec, Destination& out) {
+    size_t at = spec.find('@');
+    if (at == std::string::npos || at == 0) return false;
+    size_t colon = spec.find(':', at + 1);
+    if (colon == std::string::npos || colon == at + 1 || colon + 1 >= spec.size()) return false;
+
+    out.user = spec.substr(0, at);
+    out.ip = spec.substr(at + 1, colon - at - 1);
+    out.path = spec.substr(colon + 1);
+    while (out.path.size() > 1 && out.path.back() == '/') out.path.pop_back();
+    return true;
+}
+
+// Destination principale (REMOTE_*) suivie des destinations supplementaires
+std::vector<Destination> getDestinations() {
+    std::vector<Destination> dests;
+    if (!REMOTE_IP.empty()) dests.push_back({REMOTE_USER, REMOTE_IP, REMOTE_PATH});
+    dests.insert(dests.end(), EXTRA_DESTINATIONS.begin(), EXTRA_DESTINATIONS.end());
+    return dests;
+}
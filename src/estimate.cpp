@@ -0,0 +1,154 @@
+#include "estimate.h"
+#include "config.h"
+#include "utils.h"
+#include "process.h"
+#include "backup.h"
+
+#include <vector>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+namespace {
+
+// Strates par taille: <4K, <64K, <1M, <16M, <256M, >=256M
+const uintmax_t STRATUM_LIMITS[] = { 4ull << 10, 64ull << 10, 1ull << 20, 16ull << 20, 256ull << 20 };
+const int STRATUM_COUNT = 6;
+const size_t SAMPLES_PER_STRATUM = 8;
+const size_t SAMPLE_CHUNK = 1 << 20; // Lecture max par fichier echantillonne
+const size_t TAR_BLOCK = 512;
+
+struct Stratum {
+    uintmax_t bytes = 0;
+    uintmax_t files = 0;
+    std::vector<fs::path> reservoir;
+};
+
+int stratumOf(uintmax_t size) {
+    for (int i = 0; i < STRATUM_COUNT - 1; ++i) {
+        if (size < STRATUM_LIMITS[i]) return i;
+    }
+    return STRATUM_COUNT - 1;
+}
+
+// Envoie le debut des fichiers echantillonnes a zstd (aucune copie sur disque)
+uintmax_t streamSample(const std::vector<fs::path>& files, PipelineWriter& compressor,
+                       TokenBucket* readThrottle, double& waitSec) {
+    std::vector<char> buffer(SAMPLE_CHUNK);
+    uintmax_t total = 0;
+    for (const auto& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        if (!in) continue;
+        if (readThrottle) {
+            std::error_code ec;
+            uintmax_t size = fs::file_size(file, ec);
+            auto start = steady_clock::now();
+            readThrottle->acquire(ec ? SAMPLE_CHUNK : std::min<uintmax_t>(size, SAMPLE_CHUNK), programInterrupted);
+            waitSec += duration<double>(steady_clock::now() - start).count();
+        }
+        in.read(buffer.data(), buffer.size());
+        std::streamsize n = in.gcount();
+        if (n <= 0) continue;
+        if (!compressor.write(buffer.data(), (size_t)n)) break;
+        total += (uintmax_t)n;
+    }
+    return total;
+}
+
+} // namespace
+
+ArchiveEstimate estimateArchive(const std::vector<ArchiveEntry>& entries, const std::string& zstdPath,
+                                int level, int threads, TokenBucket* readThrottle) {
+    ArchiveEstimate est;
+    Stratum strata[STRATUM_COUNT];
+    std::mt19937_64 rng(0x5eed); // Graine fixe: echantillon reproductible
+
+    for (const auto& entry : entries) {
+        if (entry.type != '0') continue;
+        uintmax_t size = entry.size;
+        est.rawBytes += size;
+        est.fileCount++;
+
+        // Reservoir sampling par strate
+        Stratum& s = strata[stratumOf(size)];
+        s.bytes += size;
+        s.files++;
+        if (s.reservoir.size() < SAMPLES_PER_STRATUM) {
+            s.reservoir.push_back(entry.path);
+        } else {
+            std::uniform_int_distribution<uintmax_t> pick(0, s.files - 1);
+            uintmax_t slot = pick(rng);
+            if (slot < SAMPLES_PER_STRATUM) s.reservoir[slot] = entry.path;
+        }
+    }
+
+    // Compression mono-thread de chaque strate au niveau et parametres du job
+    Argv cmd = { zstdPath };
+    Argv params = splitArgs(getOptimalZstdParams(level, getAvailableRAM(), 1));
+    cmd.insert(cmd.end(), params.begin(), params.end());
+    cmd.insert(cmd.end(), { "-q", "-c" });
+    double archiveBytes = 0;
+    double sampleSec = 0;
+
+    for (int i = 0; i < STRATUM_COUNT; ++i) {
+        Stratum& s = strata[i];
+        if (s.files == 0) continue;
+
+        // zstd -c sur stdin: seule la taille de la sortie est conservee
+        double ratio = 1.0;
+        PipelineWriter compressor;
+        if (compressor.open({ cmd }, "")) {
+            auto start = steady_clock::now();
+            double waitSec = 0;
+            uintmax_t sampled = streamSample(s.reservoir, compressor, readThrottle, waitSec);
+            int res = compressor.close();
+            if (sampled > 0) {
+                sampleSec += duration<double>(steady_clock::now() - start).count() - waitSec;
+                if (res == 0) ratio = (double)compressor.outputBytes() / sampled;
+                est.sampledBytes += sampled;
+                est.sampledFiles += s.reservoir.size();
+            }
+        }
+
+        // En-tetes tar (512 octets) et bourrage inclus dans le volume a compresser
+        double tarBytes = (double)s.bytes + (double)s.files * TAR_BLOCK * 1.5;
+        archiveBytes += tarBytes * ratio;
+    }
+
+    est.archiveBytes = (uintmax_t)archiveBytes;
+
+    // Debit mono-thread mesure, extrapole au budget de threads (efficacite ~80%)
+    if (est.sampledBytes > 0 && sampleSec > 0) {
+        double bytesPerSec = est.sampledBytes / sampleSec;
+        est.compressSec = est.rawBytes / (bytesPerSec * std::max(1, threads) * 0.8);
+    }
+
+    double uploadMBps = 0;
+    try { uploadMBps = std::stod(UPLOAD_SPEED_MB); } catch (...) {}
+    if (uploadMBps > 0) est.uploadSec = est.archiveBytes / (uploadMBps * 1024.0 * 1024.0);
+
+    est.valid = est.sampledBytes > 0 || est.rawBytes == 0;
+    return est;
+}
+
+std::string formatDuration(double seconds) {
+    long s = (long)(seconds + 0.5);
+    if (s < 60) return std::to_string(s) + "s";
+    if (s < 3600) return std::to_string(s / 60) + "m" + std::to_string(s % 60) + "s";
+    return std::to_string(s / 3600) + "h" + std::to_string((s % 3600) / 60) + "m";
+}
+
+std::string formatEstimate(const ArchiveEstimate& est) {
+    double archiveMB = est.archiveBytes / (1024.0 * 1024.0);
+    int ratio = est.rawBytes > 0 ? (int)(100.0 * est.archiveBytes / est.rawBytes) : 0;
+    return "Estimation: archive ~" + std::to_string((long long)archiveMB) + " MB (ratio ~" + std::to_string(ratio)
+        + "%), compression ~" + formatDuration(est.compressSec)
+        + (est.uploadSec > 0 ? ", upload ~" + formatDuration(est.uploadSec) : "")
+        + " (echantillon: " + std::to_string(est.sampledFiles) + " fichiers, "
+        + std::to_string(est.sampledBytes / (1024 * 1024)) + " MB)";
+}
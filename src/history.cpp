@@ -0,0 +1,124 @@
+#include "history.h"
+#include "checkpoint.h"
+
+#include <map>
+#include <cmath>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::map<std::string, JobHistory> history;
+std::mutex historyMutex;
+
+// Poids de la derniere execution dans la moyenne glissante
+const double HISTORY_WEIGHT = 0.5;
+
+double blend(double previous, double current, bool hasPrevious) {
+    return hasPrevious ? previous * (1 - HISTORY_WEIGHT) + current * HISTORY_WEIGHT : current;
+}
+
+// stod accepte "inf"/"nan" et stoull un signe '-': valeurs rejetees (la simulation ne terminerait pas)
+double parseDuration(const std::string& text) {
+    double value = std::stod(text);
+    if (!std::isfinite(value) || value < 0) throw std::invalid_argument(text);
+    return value;
+}
+
+uintmax_t parseBytes(const std::string& text) {
+    if (text.find('-') != std::string::npos) throw std::invalid_argument(text);
+    return std::stoull(text);
+}
+
+} // namespace
+
+// Format: une ligne par dossier, champs separes par des tabulations
+bool loadHistory(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::lock_guard<std::mutex> lock(historyMutex);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream iss(line);
+        std::string source, raw, archive, comp, up, runs;
+        if (!std::getline(iss, source, '\t') || !std::getline(iss, raw, '\t') || !std::getline(iss, archive, '\t')
+            || !std::getline(iss, comp, '\t') || !std::getline(iss, up, '\t') || !std::getline(iss, runs, '\t')) continue;
+        try {
+            JobHistory h;
+            h.rawBytes = parseBytes(raw);
+            h.archiveBytes = parseBytes(archive);
+            h.compressSec = parseDuration(comp);
+            h.uploadSec = parseDuration(up);
+            h.runs = std::stoi(runs);
+            if (h.runs < 0) continue;
+            history[source] = h;
+        } catch (...) {}
+    }
+    return true;
+}
+
+// Fichier temporaire puis rename: un arret pendant l'ecriture conserve l'ancien historique
+bool saveHistory(const std::string& path) {
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file.is_open()) return false;
+
+        std::lock_guard<std::mutex> lock(historyMutex);
+        file << "# source\traw_bytes\tarchive_bytes\tcompress_sec\tupload_sec\truns\n";
+        for (const auto& [source, h] : history) {
+            file << source << "\t" << h.rawBytes << "\t" << h.archiveBytes << "\t"
+                 << h.compressSec << "\t" << h.uploadSec << "\t" << h.runs << "\n";
+        }
+        if (!file.good()) return false;
+    }
+    if (!syncFile(tmpPath)) return false;
+
+    std::error_code ec;
+    fs::rename(tmpPath, path, ec);
+    return !ec;
+}
+
+bool findHistory(const std::string& sourceDir, JobHistory& out) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    auto it = history.find(sourceDir);
+    if (it == history.end()) return false;
+    out = it->second;
+    return true;
+}
+
+void recordCompression(const std::string& sourceDir, uintmax_t rawBytes, uintmax_t archiveBytes, double seconds) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    JobHistory& h = history[sourceDir];
+    bool known = h.runs > 0;
+    h.rawBytes = rawBytes;
+    h.archiveBytes = archiveBytes;
+    h.compressSec = blend(h.compressSec, seconds, known);
+    h.runs++;
+}
+
+void recordUpload(const std::string& sourceDir, double seconds) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    JobHistory& h = history[sourceDir];
+    h.uploadSec = blend(h.uploadSec, seconds, h.uploadSec > 0);
+}
+
+void getHistoryRates(double& compressBytesPerSec, double& archiveRatio) {
+    std::lock_guard<std::mutex> lock(historyMutex);
+    double raw = 0, archive = 0, seconds = 0;
+    for (const auto& [source, h] : history) {
+        if (h.compressSec <= 0 || h.rawBytes == 0) continue;
+        raw += h.rawBytes;
+        archive += h.archiveBytes;
+        seconds += h.compressSec;
+    }
+    compressBytesPerSec = seconds > 0 ? raw / seconds : 0;
+    archiveRatio = raw > 0 ? archive / raw : 0;
+}
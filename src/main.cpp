@@ -16,12 +16,16 @@
 #include "utils.h"
 #include "progress.h"
 #include "backup.h"
+#include "pool.h"
+#include "history.h"
+#include "schedule.h"
+#include "estimate.h"
+#include "throttle.h"
 
 namespace fs = std::filesystem;
 
 int main(int argc, char* argv[]) {
     enableANSI();
-    setHighPriority();
     
     int cpuCores = getCPUCoreCount();
     uintmax_t availableRAM = getAvailableRAM();
@@ -46,6 +50,47 @@ int main(int argc, char* argv[]) {
     } else {
         log(-1, "SYSTEM", "Configuration chargee depuis settings.ini");
     }
+    for (const auto& spec : INVALID_DESTINATIONS) {
+        log(-1, "WARN", "Destination invalide ignoree (attendu user@ip:/chemin): " + spec);
+    }
+
+    // --estimate : estimation pre-vol seulement (ni compression, ni transfert)
+    // --background : priorites minimales et debits plafonnes (machine de production)
+    bool estimateOnly = false;
+    bool backgroundMode = BACKGROUND == "1";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--estimate") estimateOnly = true;
+        else if (arg == "--background") backgroundMode = true;
+        else if (arg.rfind("--", 0) == 0) {
+            // Une option mal tapee (--estimat) ne doit pas lancer une vraie sauvegarde
+            log(-1, "ERROR", "Option inconnue: " + arg);
+            log(-1, "INFO", "Usage: ./backup [--estimate] [--background] <dossier> [niveau]");
+            systemPause(); return 1;
+        }
+    }
+
+    // Avant tout thread: la politique d'ordonnancement et la priorite IO sont heritees
+    double readLimitMB = 0, uploadLimitMB = 0;
+    if (backgroundMode) {
+        if (!BG_CGROUP.empty()) {
+            std::string error;
+            std::vector<std::string> warnings;
+            if (joinCgroup(BG_CGROUP, error, warnings)) log(-1, "SYSTEM", "Processus place dans le cgroup " + BG_CGROUP);
+            else log(-1, "WARN", "cgroup " + BG_CGROUP + " ignore: " + error);
+            for (const auto& warning : warnings) log(-1, "WARN", "cgroup " + BG_CGROUP + ": " + warning);
+        }
+        if (!applyBackgroundPriority()) log(-1, "WARN", "Priorite arriere-plan partiellement appliquee");
+
+        try { readLimitMB = std::max(0.0, std::stod(BG_READ_MB)); } catch (...) {}
+        try { uploadLimitMB = std::max(0.0, std::stod(BG_UPLOAD_MB)); } catch (...) {}
+        sourceReadBucket.setRate(readLimitMB * 1024 * 1024);
+
+        auto limitText = [](double mb) { return mb > 0 ? std::to_string((int)mb) + " MB/s" : std::string("illimite"); };
+        log(-1, "SYSTEM", "Mode arriere-plan - lecture " + limitText(readLimitMB) + ", envoi " + limitText(uploadLimitMB));
+    } else {
+        setHighPriority();
+    }
 
     std::string zstdPath = findZstdPath(appDir);
     std::string scpPath = findScpPath();
@@ -57,6 +102,17 @@ int main(int argc, char* argv[]) {
         systemPause(); return 1;
     }
     
+    std::string agePath;
+    if (!ENCRYPT_RECIPIENT.empty()) {
+        agePath = findAgePath(appDir);
+        if (agePath.empty()) {
+            log(-1, "ERROR", "age introuvable (ENCRYPT_RECIPIENT defini)");
+            log(-1, "INFO", "Installez age (apt install age) ou placez le binaire dans tools/");
+            systemPause(); return 1;
+        }
+        log(-1, "SYSTEM", "Chiffrement actif (age)");
+    }
+    
     if (scpPath.empty()) {
         log(-1, "ERROR", "SCP introuvable. Installez OpenSSH.");
         systemPause(); return 1;
@@ -67,17 +123,32 @@ int main(int argc, char* argv[]) {
         systemPause(); return 1;
     }
     
-    // Test connexion
-    log(-1, "SYSTEM", "Test connexion SSH vers " + REMOTE_IP + "...");
-    if (!testSSHConnection(scpPath)) {
-        log(-1, "ERROR", "Impossible de se connecter a " + REMOTE_USER + "@" + REMOTE_IP);
-        log(-1, "INFO", "Verifie: cle SSH autorisee, serveur accessible, credentials corrects");
-        systemPause(); return 1;
+    // Test connexion (chaque destination): une destination injoignable est reportee, pas bloquante
+    std::vector<Destination> destinations;
+    if (!estimateOnly) {
+        std::vector<Destination> configured = getDestinations();
+        for (const auto& dest : configured) {
+            log(-1, "SYSTEM", "Test connexion SSH vers " + dest.target() + "...");
+            if (testSSHConnection(scpPath, dest)) {
+                destinations.push_back(dest);
+            } else {
+                log(-1, "WARN", "Impossible de se connecter a " + dest.target() + " - ignoree pour cette execution");
+            }
+        }
+        if (destinations.empty()) {
+            log(-1, "ERROR", "Aucune destination joignable");
+            log(-1, "INFO", "Verifie: cle SSH autorisee, serveur accessible, credentials corrects");
+            systemPause(); return 1;
+        }
+        log(-1, "SYSTEM", "Connexion SSH OK! (" + std::to_string(destinations.size()) + "/"
+            + std::to_string(configured.size()) + " destination(s))");
     }
-    log(-1, "SYSTEM", "Connexion SSH OK!");
     
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+#ifndef _WIN32
+    signal(SIGPIPE, SIG_IGN); // Compresseur arrete: write() renvoie EPIPE au lieu de tuer le processus
+#endif
 
     if (argc < 2) {
         if (justConfigured) {
@@ -93,7 +164,7 @@ int main(int argc, char* argv[]) {
             return 0;
         } else {
             log(-1, "ERROR", "Aucun dossier a sauvegarder.");
-            log(-1, "INFO", "Usage: ./backup <dossier> [niveau]");
+            log(-1, "INFO", "Usage: ./backup [--estimate] [--background] <dossier> [niveau]");
             systemPause(); return 1;
         }
     }
@@ -103,6 +174,7 @@ int main(int argc, char* argv[]) {
 
     for (int i = 1; i < argc; ++i) {
         std::string raw = argv[i];
+        if (raw.rfind("--", 0) == 0) continue; // Options deja validees
         args.push_back(cleanArg(raw));
     }
 
@@ -113,9 +185,15 @@ int main(int argc, char* argv[]) {
             BackupJob job;
             job.id = (int)jobs.size() + 1;
             job.sourceDir = currentArg;
+            std::error_code ec;
+            fs::path canonical = fs::weakly_canonical(currentArg, ec);
+            job.historyKey = ec ? currentArg : canonical.string();
             fs::path p(currentArg);
             job.baseName = p.filename().string();
             job.level = DEFAULT_LEVEL;
+            job.estimateOnly = estimateOnly;
+            job.backgroundMode = backgroundMode;
+            job.destinations = destinations;
             
             jobs.push_back(job);
         }
@@ -138,15 +216,92 @@ int main(int argc, char* argv[]) {
     int maxParallel = std::min(MAX_PARALLEL_JOBS, std::max(1, cpuCores / 4));
     if (jobs.size() == 1) maxParallel = 1;
     
+    // Un seul budget de threads zstd pour tout le processus
+    compressionPool.init(cpuCores, maxParallel);
+
+    // Plafond d'envoi reparti entre les jobs simultanes
+    if (uploadLimitMB > 0) {
+        int uploadLimitKbit = std::max(1, (int)(uploadLimitMB * 8 * 1024 / maxParallel));
+        for (auto& job : jobs) job.uploadLimitKbit = uploadLimitKbit;
+    }
+
+    // Recul adaptatif de la lecture selon la pression IO du systeme (Linux, PSI)
+    double psiThreshold = 0;
+    if (backgroundMode && !estimateOnly) {
+        try { psiThreshold = std::stod(BG_PSI_THRESHOLD); } catch (...) {}
+        if (psiThreshold > 0 && readLimitMB <= 0) {
+            log(-1, "WARN", "BG_PSI_THRESHOLD ignore: le recul sur pression IO demande un plafond BG_READ_MB");
+        } else if (psiThreshold > 0) {
+            if (readIoPressure() >= 0) {
+                startPressureMonitor(readLimitMB * 1024 * 1024, psiThreshold);
+                log(-1, "SYSTEM", "Surveillance de la pression IO (seuil " + std::to_string((int)psiThreshold) + "%)");
+            } else {
+                log(-1, "WARN", "Pression IO indisponible (/proc/pressure/io) - debit de lecture fixe");
+            }
+        }
+    }
+
+    // Ordonnancement selon l'historique des durees (makespan minimal du lot)
+    fs::path historyPath = fs::path(appDir) / "history.txt";
+    loadHistory(historyPath.string());
+
+    std::vector<JobPrediction> predictions(jobs.size());
+    if (!estimateOnly) {
+        // Dossiers sans historique: parcours + estimation, maxParallel a la fois (comme les jobs), repris en INIT
+        std::vector<BackupJob*> unknown;
+        for (auto& job : jobs) {
+            JobHistory h;
+            if (!findHistory(job.historyKey, h) || h.compressSec <= 0) unknown.push_back(&job);
+        }
+        if (!unknown.empty()) {
+            log(-1, "SYSTEM", "Analyse de " + std::to_string(unknown.size()) + " dossier(s) sans historique...");
+            std::atomic<size_t> nextScan{ 0 };
+            std::vector<std::future<void>> scans;
+            for (size_t w = 0; w < std::min(unknown.size(), (size_t)maxParallel); ++w) {
+                scans.push_back(std::async(std::launch::async, [&] {
+                    for (size_t k = nextScan++; k < unknown.size() && !programInterrupted; k = nextScan++) {
+                        unknown[k]->scan = scanJob(*unknown[k], zstdPath);
+                    }
+                }));
+            }
+            for (auto& f : scans) f.get();
+        }
+        for (size_t i = 0; i < jobs.size(); ++i) predictions[i] = predictJob(jobs[i]);
+    }
+
+    double predictedMakespan = 0;
+    std::string strategy;
+    std::vector<size_t> order = planJobOrder(predictions, maxParallel, predictedMakespan, strategy);
+
+    // Jobs lances trop tard pour reprendre leur parcours: l'estimation est deja dans la prevision,
+    // la liste des entrees est liberee tout de suite (INIT refera le parcours)
+    if (!estimateOnly) {
+        std::vector<double> startTimes;
+        simulateMakespan(predictions, order, maxParallel, &startTimes);
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (jobs[i].scan && startTimes[i] >= SCAN_REUSE_SECONDS) jobs[i].scan.reset();
+        }
+    }
+
     log(-1, "SYSTEM", "Lancement de " + std::to_string(jobs.size()) + " tache(s) - " + std::to_string(maxParallel) + " en parallele max");
+    if (jobs.size() > 1 && !estimateOnly) {
+        std::string sequence;
+        for (size_t idx : order) {
+            sequence += (sequence.empty() ? "" : ", ") + std::string("JOB ") + std::to_string(jobs[idx].id)
+                + (predictions[idx].fromHistory ? "" : "*");
+        }
+        log(-1, "SYSTEM", "Ordre (" + strategy + "): " + sequence + " - makespan prevu ~" + formatDuration(predictedMakespan)
+            + " (* = sans historique)");
+    }
     
     {
         std::lock_guard<std::mutex> lock(logMutex);
         std::cout << "============================================================" << std::endl;
     }
 
+    auto batchStart = std::chrono::steady_clock::now();
     std::vector<std::future<void>> futures;
-    for (size_t i = 0; i < jobs.size(); ++i) {
+    for (size_t i : order) {
         while (futures.size() >= (size_t)maxParallel) {
             auto it = std::find_if(futures.begin(), futures.end(),
                 [](std::future<void>& f) {
@@ -159,18 +314,29 @@ int main(int argc, char* argv[]) {
             }
         }
         
-        futures.push_back(std::async(std::launch::async, runBackupJob, jobs[i], zstdPath, scpPath));
+        futures.push_back(std::async(std::launch::async, runBackupJob, jobs[i], zstdPath, scpPath, agePath));
+        jobs[i].scan.reset(); // La copie du job garde le parcours: libere des la fin du job
     }
 
     for (auto& f : futures) {
         f.get();
     }
+    double actualMakespan = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchStart).count();
+    stopPressureMonitor();
+
+    if (!estimateOnly) {
+        saveHistory(historyPath.string());
+    }
 
     {
         std::lock_guard<std::mutex> lock(logMutex);
         std::cout << "============================================================" << std::endl;
     }
     
+    if (!estimateOnly) {
+        log(-1, "SYSTEM", "Makespan prevu ~" + formatDuration(predictedMakespan) + ", reel " + formatDuration(actualMakespan));
+    }
+
     if (programInterrupted) {
         log(-1, "SYSTEM", "PROGRAMME INTERROMPU");
     } else if (failedJobs.empty()) {
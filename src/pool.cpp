@@ -0,0 +1,219 @@
+#include "pool.h"
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <sched.h>
+    #include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+CompressionPool compressionPool;
+
+// Format sysfs: "0-7,16-23"
+static std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty()) continue;
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int c = first; c <= last; ++c) cpus.push_back(c);
+        } catch (...) {}
+    }
+    return cpus;
+}
+
+// CPUs autorises pour le processus (cpuset de conteneur, taskset); vide = inconnu
+static std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#ifndef _WIN32
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+#endif
+    return cpus;
+}
+
+// CPUs autorises groupes par noeud NUMA (un seul groupe si la topologie est inconnue)
+static std::vector<std::vector<int>> detectNumaNodes(int cpuCores) {
+    std::vector<std::vector<int>> nodes;
+    std::vector<int> allowed = allowedCpus();
+#ifndef _WIN32
+    try {
+        for (int n = 0;; ++n) {
+            fs::path cpulist = fs::path("/sys/devices/system/node") / ("node" + std::to_string(n)) / "cpulist";
+            if (!fs::exists(cpulist)) break;
+            std::ifstream file(cpulist);
+            std::string line;
+            std::getline(file, line);
+            std::vector<int> cpus = parseCpuList(line);
+            // Un slot ne doit contenir que des CPUs ou ses threads peuvent reellement tourner
+            if (!allowed.empty()) {
+                cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&](int c) {
+                    return !std::binary_search(allowed.begin(), allowed.end(), c);
+                }), cpus.end());
+            }
+            if (!cpus.empty()) nodes.push_back(cpus);
+        }
+    } catch (...) {
+        nodes.clear();
+    }
+#endif
+    if (nodes.empty()) {
+        std::vector<int> all = allowed;
+        if (all.empty()) {
+            for (int c = 0; c < cpuCores; ++c) all.push_back(c);
+        }
+        nodes.push_back(all);
+    }
+    return nodes;
+}
+
+void CompressionPool::init(int cpuCores, int maxJobs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    slots.clear();
+    maxJobs = std::max(1, maxJobs);
+    cpuCores = std::max(1, cpuCores);
+
+    std::vector<std::vector<int>> nodes = detectNumaNodes(cpuCores);
+
+    if ((int)nodes.size() >= maxJobs) {
+        // Assez de noeuds: chaque slot reste sur ses propres noeuds (memoire locale)
+        slots.resize(maxJobs);
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            auto& cpus = slots[n % maxJobs].cpus;
+            cpus.insert(cpus.end(), nodes[n].begin(), nodes[n].end());
+        }
+    } else {
+        // Sinon, tranches contigues dans l'ordre des noeuds
+        std::vector<int> all;
+        for (const auto& node : nodes) all.insert(all.end(), node.begin(), node.end());
+        slots.resize(maxJobs);
+        size_t per = std::max<size_t>(1, all.size() / maxJobs);
+        for (int s = 0; s < maxJobs; ++s) {
+            size_t first = std::min(all.size(), s * per);
+            size_t last = (s == maxJobs - 1) ? all.size() : std::min(all.size(), first + per);
+            slots[s].cpus.assign(all.begin() + first, all.begin() + last);
+        }
+    }
+
+    for (int s = 0; s < maxJobs; ++s) {
+        slots[s].id = s + 1;
+        slots[s].threads = std::max(1, (int)slots[s].cpus.size());
+        if (slots[s].cpus.empty()) slots[s].threads = std::max(1, cpuCores / maxJobs);
+    }
+}
+
+// Slot occupe + CPUs des slots libres, repartis a tour de role entre les slots occupes
+CompressionSlot CompressionPool::grantLocked(size_t index) const {
+    CompressionSlot grant = slots[index];
+    std::vector<size_t> busy;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].busy) busy.push_back(i);
+    }
+    size_t rank = std::find(busy.begin(), busy.end(), index) - busy.begin();
+    if (rank >= busy.size()) return grant;
+
+    size_t idle = 0;
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].busy || idle++ % busy.size() != rank) continue;
+        grant.cpus.insert(grant.cpus.end(), slots[i].cpus.begin(), slots[i].cpus.end());
+        grant.threads += slots[i].threads;
+    }
+    std::sort(grant.cpus.begin(), grant.cpus.end());
+    if (!grant.cpus.empty()) grant.threads = (int)grant.cpus.size();
+    return grant;
+}
+
+CompressionSlot CompressionPool::acquire() {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (slots.empty()) return CompressionSlot{};
+
+    size_t freeSlot = 0;
+    cv.wait(lock, [&] {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (!slots[i].busy) { freeSlot = i; return true; }
+        }
+        return false;
+    });
+    slots[freeSlot].busy = true;
+    return grantLocked(freeSlot);
+}
+
+CompressionSlot CompressionPool::renegotiate(const CompressionSlot& slot) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < slots.size(); ++i) {
+        if (slots[i].id == slot.id && slots[i].busy) return grantLocked(i);
+    }
+    return slot;
+}
+
+void CompressionPool::release(const CompressionSlot& slot) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& s : slots) {
+            if (s.id == slot.id) s.busy = false;
+        }
+    }
+    cv.notify_one();
+}
+
+int CompressionPool::threadsPerSlot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return slots.empty() ? 0 : slots.front().threads;
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifndef _WIN32
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c >= 0 && c < CPU_SETSIZE) CPU_SET(c, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    // Windows: CreateProcess n'herite pas de l'affinite du thread, budget -T seulement
+    (void)cpus;
+    return false;
+#endif
+}
+
+void unpinCurrentThread() {
+#ifndef _WIN32
+    // Le thread principal n'est jamais epingle: son masque est celui du processus
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(getpid(), sizeof(set), &set) == 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+#endif
+}
+
+std::string formatCpuList(const std::vector<int>& cpus) {
+    std::string out;
+    size_t i = 0;
+    while (i < cpus.size()) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (!out.empty()) out += ",";
+        out += std::to_string(cpus[i]);
+        if (j > i) out += "-" + std::to_string(cpus[j]);
+        i = j + 1;
+    }
+    return out;
+}
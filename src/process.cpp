@@ -0,0 +1,359 @@
+#include "process.h"
+
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <fstream>
+#else
+    #include <spawn.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <cerrno>
+    #include <csignal>
+    #include <sys/wait.h>
+
+    extern char** environ;
+#endif
+
+Argv splitArgs(const std::string& params) {
+    Argv args;
+    std::istringstream iss(params);
+    std::string arg;
+    while (iss >> arg) args.push_back(arg);
+    return args;
+}
+
+std::string quoteCommandLine(const Argv& argv) {
+    std::string cmd;
+    for (const auto& arg : argv) {
+        if (!cmd.empty()) cmd += " ";
+        if (arg.empty() || arg.find_first_of(" \t\"") != std::string::npos) cmd += "\"" + arg + "\"";
+        else cmd += arg;
+    }
+    return cmd;
+}
+
+#ifndef _WIN32
+
+namespace {
+
+std::vector<char*> toCArgv(const Argv& argv) {
+    std::vector<char*> cargv;
+    for (const auto& arg : argv) cargv.push_back(const_cast<char*>(arg.c_str()));
+    cargv.push_back(nullptr);
+    return cargv;
+}
+
+int waitChild(pid_t pid) {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) return -1;
+    }
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return -1;
+}
+
+// Pipe sans heritage parasite, agrandi pour limiter les changements de contexte
+bool makePipe(int fds[2]) {
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+#ifdef F_SETPIPE_SZ
+    fcntl(fds[1], F_SETPIPE_SZ, PIPELINE_PIPE_SIZE); // Echec silencieux: taille par defaut
+#endif
+    return true;
+}
+
+// stdin/stdout/stderr de l'enfant: -1 = herite du parent
+pid_t spawnChild(const Argv& argv, int inFd, int outFd, int errFd) {
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+
+    // BackStream ignore SIGPIPE; les enfants retrouvent le comportement par defaut
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t defaults;
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGDEF);
+    if (inFd >= 0) posix_spawn_file_actions_adddup2(&actions, inFd, STDIN_FILENO);
+    if (outFd >= 0) posix_spawn_file_actions_adddup2(&actions, outFd, STDOUT_FILENO);
+    if (errFd >= 0) posix_spawn_file_actions_adddup2(&actions, errFd, STDERR_FILENO);
+
+    std::vector<char*> cargv = toCArgv(argv);
+    pid_t pid = -1;
+    int rc = posix_spawnp(&pid, cargv[0], &actions, &attr, cargv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    return rc == 0 ? pid : -1;
+}
+
+} // namespace
+
+int runProcess(const Argv& argv, bool quiet) {
+    if (argv.empty()) return -1;
+    int devNull = quiet ? ::open("/dev/null", O_WRONLY | O_CLOEXEC) : -1;
+    pid_t pid = spawnChild(argv, -1, devNull, devNull);
+    if (devNull >= 0) ::close(devNull);
+    if (pid < 0) return 127;
+    return waitChild(pid);
+}
+
+PipelineWriter::~PipelineWriter() {
+    if (fd >= 0 || !pids.empty() || drain.joinable()) close();
+}
+
+bool PipelineWriter::open(const std::vector<Argv>& stages, const std::string& outputPath, bool append) {
+    if (stages.empty()) return false;
+    counted = 0;
+
+    int outFd = -1;
+    if (outputPath.empty()) {
+        // Sortie comptee puis jetee par un thread, sans fichier intermediaire
+        int output[2];
+        if (!makePipe(output)) return false;
+        outFd = output[1];
+        int readFd = output[0];
+        drain = std::thread([this, readFd]() {
+            std::vector<char> buffer(PIPELINE_PIPE_SIZE);
+            ssize_t n;
+            while ((n = ::read(readFd, buffer.data(), buffer.size())) != 0) {
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) break;
+                counted += (uintmax_t)n;
+            }
+            ::close(readFd);
+        });
+    } else {
+        outFd = ::open(outputPath.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+        if (outFd < 0) return false;
+    }
+
+    int input[2];
+    if (!makePipe(input)) {
+        ::close(outFd);
+        return false;
+    }
+    fd = input[1];
+
+    // Entre les etages, les octets circulent par le noyau sans repasser par BackStream
+    int prevRead = input[0];
+    bool ok = true;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        int fds[2] = { -1, -1 };
+        bool last = (i + 1 == stages.size());
+        if (!last && !makePipe(fds)) { ok = false; break; }
+
+        pid_t pid = spawnChild(stages[i], prevRead, last ? outFd : fds[1], -1);
+        ::close(prevRead);
+        prevRead = -1;
+        if (!last) {
+            ::close(fds[1]);
+            prevRead = fds[0];
+        }
+
+        if (pid < 0) { ok = false; break; }
+        pids.push_back(pid);
+    }
+    if (prevRead >= 0) ::close(prevRead);
+    ::close(outFd);
+
+    if (!ok) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool PipelineWriter::write(const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false; // EPIPE: le compresseur s'est arrete
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool PipelineWriter::spliceFrom(const std::string& path, uintmax_t offset, uintmax_t length, uintmax_t& moved) {
+    moved = 0;
+    int in = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) return true;
+
+    bool ok = true;
+    bool useSplice = true;
+    off_t pos = (off_t)offset;
+    std::vector<char> buffer;
+    while (moved < length) {
+        size_t chunk = (size_t)std::min<uintmax_t>(length - moved, PIPELINE_PIPE_SIZE);
+        ssize_t n;
+        if (useSplice) {
+            n = splice(in, &pos, fd, nullptr, chunk, SPLICE_F_MOVE | SPLICE_F_MORE);
+            // Systeme de fichiers sans splice: copie classique
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                useSplice = false;
+                continue;
+            }
+            if (n < 0 && errno == EPIPE) { ok = false; break; }
+        } else {
+            if (buffer.empty()) buffer.resize(PIPELINE_PIPE_SIZE);
+            n = pread(in, buffer.data(), std::min(chunk, buffer.size()), pos);
+            if (n > 0) {
+                if (!write(buffer.data(), (size_t)n)) { ok = false; break; }
+                pos += n;
+            }
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break; // Fin de fichier ou erreur de lecture
+        moved += (uintmax_t)n;
+    }
+    ::close(in);
+    return ok;
+}
+
+int PipelineWriter::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+
+    // Code du dernier etage, comme un shell, sauf si un etage amont echoue
+    int result = pids.empty() ? -1 : 0;
+    for (size_t i = 0; i < pids.size(); ++i) {
+        int code = waitChild(pids[i]);
+        if (code != 0 && (result == 0 || i + 1 == pids.size())) result = code;
+    }
+    pids.clear();
+
+    // Tous les etages sont termines: le thread de comptage recoit EOF
+    if (drain.joinable()) drain.join();
+    return result;
+}
+
+ProcessReader::~ProcessReader() {
+    if (fd >= 0 || pid > 0) close();
+}
+
+bool ProcessReader::open(const Argv& argv) {
+    int fds[2];
+    if (argv.empty() || !makePipe(fds)) return false;
+    pid = spawnChild(argv, -1, fds[1], -1);
+    ::close(fds[1]);
+    if (pid < 0) {
+        ::close(fds[0]);
+        return false;
+    }
+    fd = fds[0];
+    return true;
+}
+
+long ProcessReader::read(char* buffer, size_t size) {
+    while (true) {
+        ssize_t n = ::read(fd, buffer, size);
+        if (n >= 0) return (long)n;
+        if (errno != EINTR) return -1;
+    }
+}
+
+int ProcessReader::close() {
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+    int code = (pid > 0) ? waitChild(pid) : -1;
+    pid = -1;
+    return code;
+}
+
+#else // _WIN32
+
+int runProcess(const Argv& argv, bool quiet) {
+    // cmd.exe /c est necessaire pour que std::system() gere les chemins avec espaces
+    std::string cmd = "cmd.exe /c \"" + quoteCommandLine(argv) + (quiet ? " >nul 2>&1" : "") + "\"";
+    return std::system(cmd.c_str());
+}
+
+PipelineWriter::~PipelineWriter() {
+    if (pipe) close();
+}
+
+bool PipelineWriter::open(const std::vector<Argv>& stages, const std::string& outputPath, bool append) {
+    counted = 0;
+    std::string target = outputPath;
+    if (target.empty()) {
+        // cmd.exe ne peut pas rendre le flux au parent: fichier unique dans le %TEMP% de l'utilisateur
+        char dir[MAX_PATH];
+        char file[MAX_PATH];
+        if (!GetTempPathA(MAX_PATH, dir) || !GetTempFileNameA(dir, "bks", 0, file)) return false;
+        countPath = target = file;
+        append = false;
+    }
+
+    std::string inner;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (i > 0) inner += " | ";
+        inner += quoteCommandLine(stages[i]);
+    }
+    inner += (append ? " >> \"" : " > \"") + target + "\"";
+    // _popen passe par cmd.exe /c: guillemets externes comme pour std::system()
+    pipe = _popen(("\"" + inner + "\"").c_str(), "wb");
+    return pipe != nullptr;
+}
+
+bool PipelineWriter::write(const char* data, size_t size) {
+    return fwrite(data, 1, size, pipe) == size;
+}
+
+bool PipelineWriter::spliceFrom(const std::string& path, uintmax_t offset, uintmax_t length, uintmax_t& moved) {
+    // Pas de splice sous Windows: copie par buffer
+    moved = 0;
+    std::ifstream in(path, std::ios::binary);
+    if (in && offset > 0) in.seekg((std::streamoff)offset);
+    std::vector<char> buffer(PIPELINE_PIPE_SIZE);
+    while (in && moved < length) {
+        in.read(buffer.data(), (std::streamsize)std::min<uintmax_t>(length - moved, buffer.size()));
+        size_t got = (size_t)in.gcount();
+        if (got == 0) break;
+        if (!write(buffer.data(), got)) return false;
+        moved += got;
+    }
+    return true;
+}
+
+int PipelineWriter::close() {
+    int code = pipe ? _pclose(pipe) : -1;
+    pipe = nullptr;
+    if (!countPath.empty()) {
+        WIN32_FILE_ATTRIBUTE_DATA info;
+        if (GetFileAttributesExA(countPath.c_str(), GetFileExInfoStandard, &info)) {
+            counted = ((uintmax_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+        }
+        DeleteFileA(countPath.c_str());
+        countPath.clear();
+    }
+    return code;
+}
+
+ProcessReader::~ProcessReader() {
+    if (pipe) close();
+}
+
+bool ProcessReader::open(const Argv& argv) {
+    pipe = _popen(quoteCommandLine(argv).c_str(), "r");
+    return pipe != nullptr;
+}
+
+long ProcessReader::read(char* buffer, size_t size) {
+    // Ligne par ligne: fread attendrait un buffer plein avant de rendre la main
+    if (!fgets(buffer, (int)size, pipe)) return ferror(pipe) ? -1 : 0;
+    return (long)strlen(buffer);
+}
+
+int ProcessReader::close() {
+    int code = pipe ? _pclose(pipe) : -1;
+    pipe = nullptr;
+    return code;
+}
+
+#endif
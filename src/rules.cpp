@@ -0,0 +1,180 @@
+#include "rules.h"
+#include "config.h"
+
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool hasWildcard(const std::string& s) {
+    return s.find_first_of("*?[\\") != std::string::npos;
+}
+
+// [abc], [a-z], [!abc]; p pointe sur '['. Renvoie la fin de la classe ou nullptr.
+const char* matchClass(const char* p, char c, bool& matched) {
+    ++p;
+    bool negate = (*p == '!' || *p == '^');
+    if (negate) ++p;
+    matched = false;
+    bool first = true;
+    while (*p && (first || *p != ']')) {
+        first = false;
+        char lo = *p, hi = *p;
+        if (p[1] == '-' && p[2] && p[2] != ']') {
+            hi = p[2];
+            p += 2;
+        }
+        if (c >= lo && c <= hi) matched = true;
+        ++p;
+    }
+    if (*p != ']') return nullptr;
+    if (negate) matched = !matched;
+    return p + 1;
+}
+
+} // namespace
+
+// '*' et '?' ne traversent pas '/', "**/" couvre zero ou plusieurs dossiers, "/**" tout le contenu
+bool globMatch(const char* p, const char* t) {
+    while (*p) {
+        if (p[0] == '*' && p[1] == '*') {
+            const char* rest = p + 2;
+            if (*rest == '\0') return true;
+            if (*rest == '/') {
+                ++rest;
+                for (const char* s = t;; ++s) {
+                    if ((s == t || s[-1] == '/') && globMatch(rest, s)) return true;
+                    if (*s == '\0') return false;
+                }
+            }
+            p = rest - 1; // "a**b": equivalent a '*'
+            continue;
+        }
+        if (*p == '*') {
+            ++p;
+            for (const char* s = t;; ++s) {
+                if (globMatch(p, s)) return true;
+                if (*s == '\0' || *s == '/') return false;
+            }
+        }
+        if (*t == '\0') return false;
+        if (*p == '?') {
+            if (*t == '/') return false;
+        } else if (*p == '[') {
+            bool matched;
+            const char* end = matchClass(p, *t, matched);
+            if (!end) {
+                if (*t != '[') return false; // Classe mal formee: '[' litteral
+            } else {
+                if (!matched || *t == '/') return false;
+                p = end;
+                ++t;
+                continue;
+            }
+        } else {
+            if (*p == '\\' && p[1]) ++p;
+            if (*p != *t) return false;
+        }
+        ++p;
+        ++t;
+    }
+    return *t == '\0';
+}
+
+void RuleSet::add(const std::string& rawLine) {
+    std::string line = rawLine;
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t')) line.pop_back();
+    if (line.empty() || line[0] == '#') return;
+
+    Rule rule;
+    rule.text = line;
+    if (line[0] == '!') {
+        rule.negate = true;
+        line.erase(0, 1);
+    } else if (line[0] == '\\' && line.size() > 1 && (line[1] == '#' || line[1] == '!')) {
+        line.erase(0, 1);
+    }
+    if (!line.empty() && line.back() == '/') {
+        rule.dirOnly = true;
+        line.pop_back();
+    }
+    // Un '/' ailleurs qu'a la fin ancre le motif a la racine du job
+    if (line.find('/') != std::string::npos) {
+        rule.anchored = true;
+        if (line[0] == '/') line.erase(0, 1);
+    }
+    if (line.empty()) return;
+    rule.glob = line;
+
+    int index = (int)rules.size();
+    rules.push_back(rule);
+    ruleStats.emplace_back();
+
+    if (!hasWildcard(line)) {
+        (rule.anchored ? byPath : byName)[line].push_back(index);
+    } else if (!rule.anchored && line[0] == '*' && line.size() > 1 && !hasWildcard(line.substr(1))) {
+        std::string suffix = line.substr(1);
+        bySuffix[suffix].push_back(index);
+        if (std::find(suffixLengths.begin(), suffixLengths.end(), suffix.size()) == suffixLengths.end()) {
+            suffixLengths.push_back(suffix.size());
+        }
+    } else {
+        globs.push_back(index);
+    }
+}
+
+int RuleSet::bestOf(const std::vector<int>& candidates, bool isDir, int best) const {
+    for (auto it = candidates.rbegin(); it != candidates.rend() && *it > best; ++it) {
+        if (accepts(*it, isDir)) return *it;
+    }
+    return best;
+}
+
+int RuleSet::match(const std::string& relPath, const std::string& name, bool isDir) const {
+    int best = -1;
+
+    auto named = byName.find(name);
+    if (named != byName.end()) best = bestOf(named->second, isDir, best);
+
+    auto pathed = byPath.find(relPath);
+    if (pathed != byPath.end()) best = bestOf(pathed->second, isDir, best);
+
+    for (size_t len : suffixLengths) {
+        if (len > name.size()) continue;
+        auto suffixed = bySuffix.find(name.substr(name.size() - len));
+        if (suffixed != bySuffix.end()) best = bestOf(suffixed->second, isDir, best);
+    }
+
+    // Motifs generiques du plus recent au plus ancien, arret des qu'ils ne peuvent plus l'emporter
+    for (auto it = globs.rbegin(); it != globs.rend() && *it > best; ++it) {
+        const Rule& rule = rules[*it];
+        if (!accepts(*it, isDir)) continue;
+        const std::string& subject = rule.anchored ? relPath : name;
+        if (globMatch(rule.glob.c_str(), subject.c_str())) {
+            best = *it;
+            break;
+        }
+    }
+    return best;
+}
+
+void RuleSet::countHit(int rule, bool isDir, uintmax_t bytes) {
+    if (rule < 0) return;
+    RuleStats& s = ruleStats[rule];
+    if (isDir) s.dirs++;
+    else s.files++;
+    s.bytes += bytes;
+}
+
+RuleSet loadJobRules(const std::string& sourceDir) {
+    RuleSet rules;
+    for (const auto& line : EXCLUDE_RULES) rules.add(line);
+
+    std::ifstream file(fs::path(sourceDir) / ".backstreamignore");
+    std::string line;
+    while (std::getline(file, line)) rules.add(line);
+    return rules;
+}
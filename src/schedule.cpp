@@ -0,0 +1,138 @@
+#include "schedule.h"
+#include "history.h"
+#include "config.h"
+
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+
+namespace {
+
+// Debit par defaut si ni l'historique ni l'echantillon ne donnent de mesure
+const double DEFAULT_COMPRESS_MBPS = 150.0;
+const double EPSILON = 1e-6;
+
+double uploadBytesPerSec() {
+    double mbps = 0;
+    try { mbps = std::stod(UPLOAD_SPEED_MB); } catch (...) {}
+    return (mbps > 0 ? mbps : 100.0) * 1024.0 * 1024.0;
+}
+
+} // namespace
+
+JobPrediction predictJob(const BackupJob& job) {
+    JobPrediction p;
+    JobHistory h;
+    if (findHistory(job.historyKey, h) && h.compressSec > 0) {
+        p.compressSec = h.compressSec;
+        p.uploadSec = h.uploadSec > 0 ? h.uploadSec : h.archiveBytes / uploadBytesPerSec();
+        p.fromHistory = true;
+        return p;
+    }
+
+    // Premier passage: estimation echantillonnee du parcours prealable (scanJob)
+    if (!job.scan) return p;
+    const ArchiveEstimate& est = job.scan->estimate;
+
+    double rate = 0, ratio = 0;
+    getHistoryRates(rate, ratio);
+    if (rate <= 0) rate = DEFAULT_COMPRESS_MBPS * 1024.0 * 1024.0;
+
+    // Echantillon inexploitable: debit et ratio moyens de l'historique, sinon archive = taille brute
+    double archiveBytes = est.valid ? (double)est.archiveBytes : est.rawBytes * (ratio > 0 ? ratio : 1.0);
+    p.compressSec = est.compressSec > 0 ? est.compressSec : est.rawBytes / rate;
+    p.uploadSec = archiveBytes / uploadBytesPerSec();
+    return p;
+}
+
+double simulateMakespan(const std::vector<JobPrediction>& preds, const std::vector<size_t>& order, int slots,
+                        std::vector<double>* startTimes) {
+    struct Running {
+        size_t job;
+        bool uploading;
+        double remaining; // Secondes de travail (upload: a debit reseau plein)
+    };
+
+    std::vector<Running> running;
+    size_t next = 0;
+    double t = 0;
+    slots = std::max(1, slots);
+    if (startTimes) startTimes->assign(preds.size(), 0);
+
+    while (next < order.size() || !running.empty()) {
+        while ((int)running.size() < slots && next < order.size()) {
+            size_t j = order[next++];
+            if (startTimes) (*startTimes)[j] = t;
+            running.push_back({ j, false, preds[j].compressSec });
+        }
+
+        // Transitions de phase et fins de job
+        for (size_t i = 0; i < running.size();) {
+            Running& r = running[i];
+            if (!r.uploading && r.remaining <= EPSILON) {
+                r.uploading = true;
+                r.remaining = preds[r.job].uploadSec;
+            }
+            if (r.uploading && r.remaining <= EPSILON) {
+                running.erase(running.begin() + i);
+                continue;
+            }
+            ++i;
+        }
+        if (running.empty()) continue;
+
+        // Les k uploads simultanes avancent chacun a 1/k du debit
+        int uploads = (int)std::count_if(running.begin(), running.end(), [](const Running& r) { return r.uploading; });
+        double dt = -1;
+        for (const auto& r : running) {
+            double until = r.uploading ? r.remaining * uploads : r.remaining;
+            if (dt < 0 || until < dt) dt = until;
+        }
+        if (!std::isfinite(dt)) return dt; // Prevision aberrante: pas de simulation possible
+        t += dt;
+        for (auto& r : running) {
+            r.remaining -= r.uploading ? dt / uploads : dt;
+        }
+    }
+    return t;
+}
+
+std::vector<size_t> planJobOrder(const std::vector<JobPrediction>& preds, int slots,
+                                 double& predictedMakespan, std::string& strategy) {
+    std::vector<size_t> initial(preds.size());
+    std::iota(initial.begin(), initial.end(), 0);
+
+    // LPT: les plus longs d'abord (compression + upload)
+    std::vector<size_t> lpt = initial;
+    std::stable_sort(lpt.begin(), lpt.end(), [&](size_t a, size_t b) {
+        return preds[a].compressSec + preds[a].uploadSec > preds[b].compressSec + preds[b].uploadSec;
+    });
+
+    // Regle de Johnson (compression puis upload): upload dominant en tete par compression
+    // croissante, puis compression dominante par upload decroissant
+    std::vector<size_t> johnson = initial;
+    std::stable_sort(johnson.begin(), johnson.end(), [&](size_t a, size_t b) {
+        bool aFirst = preds[a].compressSec < preds[a].uploadSec;
+        bool bFirst = preds[b].compressSec < preds[b].uploadSec;
+        if (aFirst != bFirst) return aFirst;
+        if (aFirst) return preds[a].compressSec < preds[b].compressSec;
+        return preds[a].uploadSec > preds[b].uploadSec;
+    });
+
+    const std::pair<const char*, std::vector<size_t>*> candidates[] = {
+        { "ordre initial", &initial }, { "LPT", &lpt }, { "Johnson", &johnson }
+    };
+
+    std::vector<size_t> best = initial;
+    predictedMakespan = simulateMakespan(preds, initial, slots);
+    strategy = candidates[0].first;
+    for (const auto& [name, order] : candidates) {
+        double makespan = simulateMakespan(preds, *order, slots);
+        if (makespan < predictedMakespan - EPSILON) {
+            predictedMakespan = makespan;
+            best = *order;
+            strategy = name;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,180 @@
+#include "throttle.h"
+#include "progress.h"
+
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <condition_variable>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace std::chrono;
+
+TokenBucket sourceReadBucket;
+
+namespace {
+
+const double BURST_SECONDS = 0.5;          // Rafale toleree
+const double MIN_RATE = 1024.0 * 1024.0;   // Plancher du recul adaptatif (1 MB/s)
+const auto PRESSURE_PERIOD = seconds(2);
+
+std::thread monitorThread;
+std::mutex monitorMutex;
+std::condition_variable monitorCv;
+bool monitorStop = false;
+
+} // namespace
+
+void TokenBucket::setRate(double bytesPerSec) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ratePerSec = std::max(0.0, bytesPerSec);
+    tokens = std::min(tokens, ratePerSec * BURST_SECONDS);
+    last = steady_clock::now();
+}
+
+double TokenBucket::rate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return ratePerSec;
+}
+
+void TokenBucket::acquire(uintmax_t bytes, const std::atomic<bool>& cancel) {
+    double wait;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (ratePerSec <= 0) return;
+        auto now = steady_clock::now();
+        tokens = std::min(ratePerSec * BURST_SECONDS, tokens + duration<double>(now - last).count() * ratePerSec);
+        last = now;
+        // Dette autorisee: une grosse lecture passe, les suivantes attendent d'autant
+        tokens -= (double)bytes;
+        wait = tokens < 0 ? -tokens / ratePerSec : 0;
+    }
+
+    auto deadline = steady_clock::now() + duration_cast<steady_clock::duration>(duration<double>(wait));
+    while (!cancel && steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::min<steady_clock::duration>(milliseconds(100), deadline - steady_clock::now()));
+    }
+}
+
+bool applyBackgroundPriority() {
+#ifdef _WIN32
+    // IDLE_PRIORITY_CLASS est herite par les processus enfants (zstd, scp)
+    bool ok = SetPriorityClass(GetCurrentProcess(), IDLE_PRIORITY_CLASS) != 0;
+    SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN); // IO et memoire basse priorite
+    return ok;
+#else
+    // Appele depuis le thread principal avant tout autre thread: herite par threads et enfants
+    struct sched_param param = {};
+    bool ok = sched_setscheduler(0, SCHED_IDLE, &param) == 0;
+
+    const int IOPRIO_CLASS_IDLE = 3;
+    const int IOPRIO_CLASS_SHIFT = 13;
+    const int IOPRIO_WHO_PROCESS = 1;
+    ok = syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) == 0 && ok;
+    return ok;
+#endif
+}
+
+bool joinCgroup(const std::string& cgroupPath, std::string& error, std::vector<std::string>& warnings) {
+#ifdef _WIN32
+    (void)cgroupPath;
+    (void)warnings;
+    error = "cgroups non disponibles sous Windows";
+    return false;
+#else
+    std::error_code ec;
+    fs::create_directories(cgroupPath, ec);
+    if (ec) {
+        error = "creation impossible: " + ec.message();
+        return false;
+    }
+
+    // Poids minimaux (1-10000, defaut 100); sans controleur delegue le fichier n'existe pas
+    const std::pair<const char*, const char*> weights[] = { { "cpu.weight", "10" }, { "io.weight", "default 10" } };
+    for (const auto& [file, value] : weights) {
+        std::ofstream out(fs::path(cgroupPath) / file);
+        out << value << "\n";
+        out.flush();
+        if (!out.good()) {
+            warnings.push_back(std::string(file) + " non applique (controleur non delegue au cgroup parent?)");
+        }
+    }
+
+    std::ofstream procs(fs::path(cgroupPath) / "cgroup.procs");
+    procs << getpid() << "\n";
+    procs.flush();
+    if (!procs.good()) {
+        error = "ecriture de cgroup.procs refusee (delegation cgroup v2 requise)";
+        return false;
+    }
+    return true;
+#endif
+}
+
+double readIoPressure() {
+#ifdef _WIN32
+    return -1;
+#else
+    std::ifstream file("/proc/pressure/io");
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.rfind("some ", 0) != 0) continue;
+        std::istringstream iss(line);
+        std::string field;
+        while (iss >> field) {
+            if (field.rfind("avg10=", 0) == 0) {
+                try { return std::stod(field.substr(6)); } catch (...) { return -1; }
+            }
+        }
+    }
+    return -1;
+#endif
+}
+
+void startPressureMonitor(double maxRate, double thresholdPct) {
+    if (maxRate <= 0 || thresholdPct <= 0 || readIoPressure() < 0) return;
+    monitorStop = false;
+
+    monitorThread = std::thread([maxRate, thresholdPct]() {
+        bool backingOff = false;
+        std::unique_lock<std::mutex> lock(monitorMutex);
+        while (!monitorCv.wait_for(lock, PRESSURE_PERIOD, [] { return monitorStop; })) {
+            double pressure = readIoPressure();
+            if (pressure < 0) return;
+
+            double rate = sourceReadBucket.rate();
+            if (pressure > thresholdPct) {
+                sourceReadBucket.setRate(std::max(MIN_RATE, rate / 2));
+                if (!backingOff) {
+                    log(-1, "SYSTEM", "Pression IO " + std::to_string((int)pressure) + "% - lecture ralentie");
+                    backingOff = true;
+                }
+            } else if (pressure < thresholdPct / 2 && rate < maxRate) {
+                sourceReadBucket.setRate(std::min(maxRate, rate * 1.25));
+                if (backingOff && rate * 1.25 >= maxRate) {
+                    log(-1, "SYSTEM", "Pression IO normale - debit de lecture retabli");
+                    backingOff = false;
+                }
+            }
+        }
+    });
+}
+
+void stopPressureMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(monitorMutex);
+        monitorStop = true;
+    }
+    monitorCv.notify_all();
+    if (monitorThread.joinable()) monitorThread.join();
+}
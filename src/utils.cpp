@@ -13,6 +13,7 @@
     #include <psapi.h>
     #pragma comment(lib, "psapi.lib")
 #else
+    #include <sched.h>
     #include <unistd.h>
     #include <sys/stat.h>
     #include <sys/sysinfo.h>
@@ -47,6 +48,10 @@ int getCPUCoreCount() {
     GetSystemInfo(&sysinfo);
     return sysinfo.dwNumberOfProcessors;
 #else
+    // CPUs reellement utilisables (cpuset de conteneur, taskset), sinon CPUs en ligne
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) return CPU_COUNT(&set);
     return sysconf(_SC_NPROCESSORS_ONLN);
 #endif
 }
@@ -97,6 +102,28 @@ std::string findZstdPath(const std::string& appDir) {
 #endif
 }
 
+std::string findAgePath(const std::string& appDir) {
+#ifdef _WIN32
+    std::string binName = "age.exe";
+#else
+    std::string binName = "age";
+#endif
+
+    std::vector<std::string> searchPaths = {
+        (fs::path(appDir) / "tools" / binName).string(),
+        (fs::path(appDir) / binName).string(),
+        "/usr/bin/age",
+        "/usr/local/bin/age"
+    };
+
+    for (const auto& path : searchPaths) {
+        if (fs::exists(path)) {
+            return fs::absolute(path).string();
+        }
+    }
+    return "";
+}
+
 std::string getCurrentDate() {
     std::time_t now = std::time(nullptr);
     std::tm ltm;
@@ -138,7 +165,7 @@ bool hasEnoughDiskSpace(const std::string& path, uintmax_t requiredBytes) {
     }
 }
 
-bool testSSHConnection(const std::string& scpPath) {
+bool testSSHConnection(const std::string& scpPath, const Destination& dest) {
     std::string sshPath = scpPath;
     
 #ifdef _WIN32
@@ -146,19 +173,14 @@ bool testSSHConnection(const std::string& scpPath) {
     size_t pos = sshPath.find("scp.exe");
     if (pos != std::string::npos) sshPath.replace(pos, 7, "ssh.exe");
     else sshPath = "ssh";
-    
-    // cmd.exe /c est nécessaire pour que std::system() fonctionne correctement avec des chemins contenant des espaces
-    std::string testCmd = "cmd.exe /c " + sshPath + " -i \"" + SSH_KEY + "\" -o ConnectTimeout=5 -o StrictHostKeyChecking=no -o BatchMode=yes " + REMOTE_USER + "@" + REMOTE_IP + " exit >nul 2>&1";
 #else
     // Linux logic
     if (sshPath == "scp") sshPath = "ssh";
-    
-    // /dev/null pour cacher la sortie
-    std::string testCmd = sshPath + " -i \"" + SSH_KEY + "\" -o ConnectTimeout=5 -o StrictHostKeyChecking=no -o BatchMode=yes " + REMOTE_USER + "@" + REMOTE_IP + " exit >/dev/null 2>&1";
 #endif
     
-    int result = std::system(testCmd.c_str());
-    return result == 0;
+    Argv testCmd = { sshPath, "-i", SSH_KEY, "-o", "ConnectTimeout=5", "-o", "StrictHostKeyChecking=no",
+                     "-o", "BatchMode=yes", dest.login(), "exit" };
+    return runProcess(testCmd, true) == 0;
 }
 
 bool isValidLevel(const std::string& s) {
@@ -184,7 +206,7 @@ std::string cleanArg(std::string str) {
     return str;
 }
 
-std::string getOptimalZstdParams(int level, uintmax_t availableRAM) {
+std::string getOptimalZstdParams(int level, uintmax_t availableRAM, int threads) {
     std::string params = "-" + std::to_string(level) + " --long";
     
     if (availableRAM > 16000) {
@@ -195,10 +217,17 @@ std::string getOptimalZstdParams(int level, uintmax_t availableRAM) {
         params += "=27"; 
     }
     
-    params += " -T0";
+    // threads = 0 : zstd utilise tous les coeurs
+    params += " -T" + std::to_string(threads);
     return params;
 }
 
+// age chiffre en flux (ChaCha20-Poly1305, blocs authentifies de 64 KB)
+Argv getAgeParams() {
+    bool isKey = ENCRYPT_RECIPIENT.rfind("age1", 0) == 0 || ENCRYPT_RECIPIENT.rfind("ssh-", 0) == 0;
+    return { isKey ? "-r" : "-R", ENCRYPT_RECIPIENT };
+}
+
 void systemPause() {
 #ifdef _WIN32
     std::system("pause > nul");